@@ -0,0 +1,361 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ai_cache.h"
+#include "storage.h"
+
+#define CACHE_MAGIC "SRMSAIC2"
+#define CACHE_MAGIC_V1 "SRMSAIC1" /* records without checksums; rewritten on open */
+#define CACHE_TOMBSTONE (-1)
+
+/* On-disk record body; risk == CACHE_TOMBSTONE drops every entry of roll */
+typedef struct {
+    uint64_t key;
+    int32_t roll;
+    int32_t risk;
+    double marks[NUM_SUBJECTS];
+    double attendance;
+    char career[AI_CAREER_LEN];
+    char explanation[AI_EXPLAIN_LEN];
+} CacheRecord;
+
+/* What version 2 files store: the body and an FNV-1a checksum over it */
+typedef struct {
+    CacheRecord r;
+    uint32_t checksum;
+    uint32_t reserved;
+} SealedRecord;
+
+typedef struct {
+    AiCacheEntry e;
+    size_t roll_next; /* previous entry for the same roll + 1, 0 ends the chain */
+    bool dead;
+} CacheSlotEntry;
+
+/* Per-roll chain of entries, so invalidating a roll touches only its own entries */
+typedef struct {
+    int roll;
+    bool used;
+    size_t head; /* newest entry for roll + 1, 0 when none is live */
+} RollChain;
+
+static CacheSlotEntry *entries = NULL; /* insertion order */
+static size_t entry_count = 0, entry_cap = 0, dead_count = 0;
+static size_t file_garbage = 0; /* records in the file that no longer describe a live entry */
+static size_t *table = NULL; /* open addressing: entry index + 1, 0 = empty */
+static size_t table_cap = 0;
+static RollChain *rolls = NULL; /* open addressing on roll, same capacity as table */
+static FILE *cache_fp = NULL;
+static char cache_path[512] = "";
+static AiCacheStats stats;
+
+uint64_t ai_cache_key(const char *student_json, const char *model, int prompt_version) {
+    uint64_t h = 1469598103934665603ULL;
+    const char *parts[2] = { student_json ? student_json : "", model ? model : "" };
+    for (int k = 0; k < 2; ++k) {
+        for (const unsigned char *p = (const unsigned char *)parts[k]; *p; ++p) {
+            h ^= *p;
+            h *= 1099511628211ULL;
+        }
+        h ^= 0xff; /* separator so ("ab","c") != ("a","bc") */
+        h *= 1099511628211ULL;
+    }
+    for (int i = 0; i < 4; ++i) {
+        h ^= (uint64_t)((prompt_version >> (8 * i)) & 0xff);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static size_t table_home(uint64_t key) {
+    return (size_t)(key ^ (key >> 29)) & (table_cap - 1);
+}
+
+static void table_put(size_t idx) {
+    size_t i = table_home(entries[idx].e.key);
+    while (table[i]) i = (i + 1) & (table_cap - 1);
+    table[i] = idx + 1;
+}
+
+/* Chain slot of roll, claimed if absent when create (there is always room: the
+   table holds at most one slot per entry and is at most half full) */
+static RollChain *roll_chain(int roll, bool create) {
+    if (!rolls) return NULL;
+    size_t mask = table_cap - 1;
+    for (size_t i = ((unsigned)roll * 2654435761u) & mask;; i = (i + 1) & mask) {
+        if (rolls[i].used && rolls[i].roll == roll) return &rolls[i];
+        if (!rolls[i].used) {
+            if (!create) return NULL;
+            rolls[i].used = true;
+            rolls[i].roll = roll;
+            rolls[i].head = 0;
+            return &rolls[i];
+        }
+    }
+}
+
+static void roll_link(size_t idx) {
+    RollChain *c = roll_chain(entries[idx].e.roll, true);
+    entries[idx].roll_next = c->head;
+    c->head = idx + 1;
+}
+
+/* Rebuild the tables from live entries, compacting the entry array */
+static bool rebuild(size_t want_cap) {
+    size_t cap = 64;
+    while (cap < want_cap * 2) cap *= 2;
+    size_t *nt = (size_t *)calloc(cap, sizeof(size_t));
+    RollChain *nr = (RollChain *)calloc(cap, sizeof(RollChain));
+    if (!nt || !nr) {
+        free(nt);
+        free(nr);
+        return false;
+    }
+    size_t live = 0;
+    for (size_t i = 0; i < entry_count; ++i)
+        if (!entries[i].dead) entries[live++] = entries[i];
+    entry_count = live;
+    dead_count = 0;
+    free(table);
+    free(rolls);
+    table = nt;
+    rolls = nr;
+    table_cap = cap;
+    for (size_t i = 0; i < entry_count; ++i) {
+        table_put(i);
+        roll_link(i);
+    }
+    return true;
+}
+
+static CacheSlotEntry *find(uint64_t key) {
+    if (!table) return NULL;
+    for (size_t i = table_home(key); table[i]; i = (i + 1) & (table_cap - 1)) {
+        CacheSlotEntry *ce = &entries[table[i] - 1];
+        if (ce->e.key == key && !ce->dead) return ce;
+    }
+    return NULL;
+}
+
+static void record_from_entry(CacheRecord *r, const AiCacheEntry *e) {
+    memset(r, 0, sizeof(*r));
+    r->key = e->key;
+    r->roll = e->roll;
+    r->risk = (int32_t)e->result.risk;
+    for (int i = 0; i < NUM_SUBJECTS; ++i) r->marks[i] = e->marks[i];
+    r->attendance = e->attendance;
+    snprintf(r->career, sizeof(r->career), "%s", e->result.career);
+    snprintf(r->explanation, sizeof(r->explanation), "%s", e->result.explanation);
+}
+
+static uint32_t record_checksum(const CacheRecord *r) {
+    uint32_t h = 2166136261U;
+    const unsigned char *p = (const unsigned char *)r;
+    for (size_t i = 0; i < sizeof(*r); ++i) h = (h ^ p[i]) * 16777619U;
+    return h;
+}
+
+static bool write_record(FILE *f, const CacheRecord *r) {
+    SealedRecord s;
+    memset(&s, 0, sizeof(s));
+    s.r = *r;
+    s.checksum = record_checksum(r);
+    return fwrite(&s, sizeof(s), 1, f) == 1;
+}
+
+/* Replace the file with the live entries only, through a temp file so a crash
+   keeps the old one */
+static bool rewrite_file(void) {
+    char tmp_path[sizeof(cache_path) + 4];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path);
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(CACHE_MAGIC, 1, 8, f) == 8;
+    for (size_t i = 0; ok && i < entry_count; ++i) {
+        if (entries[i].dead) continue;
+        CacheRecord r;
+        record_from_entry(&r, &entries[i].e);
+        ok = write_record(f, &r);
+    }
+    ok = storage_sync(f) && ok;
+    if (fclose(f) != 0) ok = false;
+    if (!ok || !storage_replace(tmp_path, cache_path)) {
+        remove(tmp_path);
+        return false;
+    }
+    file_garbage = 0;
+    return true;
+}
+
+static void insert_entry(const AiCacheEntry *e) {
+    CacheSlotEntry *old = find(e->key);
+    if (old && old->e.roll == e->roll) {
+        old->e = *e;
+        ++file_garbage; /* the record it replaces is still in the file */
+        return;
+    }
+    if (old) {
+        /* same key under another roll: it belongs to that roll's chain, so retire it */
+        old->dead = true;
+        ++dead_count;
+        ++file_garbage;
+    }
+    if (entry_count == entry_cap) {
+        size_t ncap = entry_cap ? entry_cap * 2 : 64;
+        CacheSlotEntry *ne = (CacheSlotEntry *)realloc(entries, ncap * sizeof(CacheSlotEntry));
+        if (!ne) return;
+        entries = ne;
+        entry_cap = ncap;
+    }
+    entries[entry_count].e = *e;
+    entries[entry_count].dead = false;
+    ++entry_count;
+    /* keep the table at most half full (dead entries included) */
+    if (entry_count * 2 > table_cap) {
+        if (!rebuild(entry_count - dead_count)) --entry_count;
+    } else {
+        table_put(entry_count - 1);
+        roll_link(entry_count - 1);
+    }
+}
+
+static void drop_roll(int roll) {
+    RollChain *c = roll_chain(roll, false);
+    if (!c) return;
+    for (size_t i = c->head; i; i = entries[i - 1].roll_next) {
+        CacheSlotEntry *ce = &entries[i - 1];
+        if (ce->dead) continue;
+        ce->dead = true;
+        ++dead_count;
+        ++file_garbage;
+        ++stats.invalidations;
+    }
+    c->head = 0;
+}
+
+bool ai_cache_open(const char *path) {
+    ai_cache_close();
+    snprintf(cache_path, sizeof(cache_path), "%s", path);
+    FILE *f = fopen(path, "rb");
+    if (f) {
+        char magic[8];
+        bool v1 = false;
+        if (fread(magic, 1, sizeof(magic), f) != sizeof(magic) ||
+            (memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0 && !(v1 = memcmp(magic, CACHE_MAGIC_V1, sizeof(magic)) == 0))) {
+            fclose(f);
+            return false;
+        }
+        /* stop at the first torn or corrupt record; the file is cut back below */
+        bool intact = true;
+        size_t want = v1 ? sizeof(CacheRecord) : sizeof(SealedRecord);
+        SealedRecord s;
+        for (;;) {
+            size_t got = fread(&s, 1, want, f);
+            if (got == 0 && !ferror(f)) break;
+            const CacheRecord r = s.r;
+            if (got != want || (!v1 && s.checksum != record_checksum(&r)) ||
+                (r.risk != CACHE_TOMBSTONE && (r.risk < RISK_LOW || r.risk > RISK_HIGH))) {
+                intact = false;
+                break;
+            }
+            if (r.risk == CACHE_TOMBSTONE) {
+                drop_roll(r.roll);
+                continue;
+            }
+            AiCacheEntry e;
+            memset(&e, 0, sizeof(e));
+            e.key = r.key;
+            e.roll = r.roll;
+            for (int i = 0; i < NUM_SUBJECTS; ++i) e.marks[i] = r.marks[i];
+            e.attendance = r.attendance;
+            e.result.risk = (RiskLevel)r.risk;
+            memcpy(e.result.career, r.career, AI_CAREER_LEN);
+            e.result.career[AI_CAREER_LEN-1] = '\0';
+            memcpy(e.result.explanation, r.explanation, AI_EXPLAIN_LEN);
+            e.result.explanation[AI_EXPLAIN_LEN-1] = '\0';
+            e.result.source = AI_SOURCE_CACHE;
+            insert_entry(&e);
+        }
+        fclose(f);
+        stats.invalidations = 0;
+        /* appending after a partial record would misalign everything written later */
+        if ((v1 || !intact) && !rewrite_file()) return false;
+        cache_fp = fopen(path, "ab");
+    } else {
+        cache_fp = fopen(path, "wb");
+        if (cache_fp && fwrite(CACHE_MAGIC, 1, 8, cache_fp) != 8) {
+            fclose(cache_fp);
+            cache_fp = NULL;
+        }
+    }
+    return cache_fp != NULL;
+}
+
+void ai_cache_close(void) {
+    if (cache_fp) {
+        fclose(cache_fp);
+        cache_fp = NULL;
+        /* rewrite without dead entries and tombstones once they dominate the file */
+        if (file_garbage > 0 && file_garbage >= entry_count - dead_count) rewrite_file();
+    }
+    free(entries);
+    free(table);
+    free(rolls);
+    entries = NULL;
+    table = NULL;
+    rolls = NULL;
+    entry_count = entry_cap = dead_count = table_cap = file_garbage = 0;
+    memset(&stats, 0, sizeof(stats));
+}
+
+bool ai_cache_lookup(uint64_t key, AiResult *out) {
+    CacheSlotEntry *ce = find(key);
+    if (!ce) {
+        ++stats.misses;
+        return false;
+    }
+    ++stats.hits;
+    *out = ce->e.result;
+    out->source = AI_SOURCE_CACHE;
+    return true;
+}
+
+void ai_cache_store(uint64_t key, const Student *s, const AiResult *r) {
+    if (!s || !r) return;
+    AiCacheEntry e;
+    memset(&e, 0, sizeof(e));
+    e.key = key;
+    e.roll = s->roll;
+    for (int i = 0; i < NUM_SUBJECTS; ++i) e.marks[i] = s->marks[i];
+    e.attendance = s->attendance;
+    e.result = *r;
+    insert_entry(&e);
+    ++stats.stores;
+    if (cache_fp) {
+        CacheRecord rec;
+        record_from_entry(&rec, &e);
+        if (write_record(cache_fp, &rec)) fflush(cache_fp);
+    }
+}
+
+void ai_cache_invalidate_roll(int roll) {
+    size_t before = dead_count;
+    drop_roll(roll);
+    if (dead_count == before || !cache_fp) return;
+    CacheRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.roll = roll;
+    rec.risk = CACHE_TOMBSTONE;
+    if (write_record(cache_fp, &rec)) fflush(cache_fp);
+}
+
+void ai_cache_stats(AiCacheStats *out) {
+    if (!out) return;
+    *out = stats;
+    out->entries = entry_count - dead_count;
+}
+
+void ai_cache_foreach(void (*fn)(const AiCacheEntry *e, void *ctx), void *ctx) {
+    for (size_t i = 0; i < entry_count; ++i)
+        if (!entries[i].dead) fn(&entries[i].e, ctx);
+}
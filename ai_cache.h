@@ -0,0 +1,60 @@
+#ifndef AI_CACHE_H
+#define AI_CACHE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "student.h"
+#include "openai_ai.h"
+
+/* Persistent content-addressed cache of parsed AI results.
+   Key = hash(student JSON sent to the model, model name, prompt version), so any
+   change to the record (or to the prompt/model) yields a different key. Entries
+   also remember roll and features so they can be invalidated by roll and reused
+   as training data. */
+
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t stores;
+    uint64_t invalidations;
+    size_t entries; /* live entries */
+} AiCacheStats;
+
+/* One cached answer together with the inputs it was computed from */
+typedef struct {
+    uint64_t key;
+    int roll;
+    double marks[NUM_SUBJECTS];
+    double attendance;
+    AiResult result;
+} AiCacheEntry;
+
+/* Hash of the request identity. */
+uint64_t ai_cache_key(const char *student_json, const char *model, int prompt_version);
+
+/* Load entries from path and persist new ones there (appending). Without a call
+   the cache works in memory only. Records are checksummed: loading stops at the
+   first torn or corrupt one and the file is rewritten without it before any
+   append. Returns false if path exists but is unreadable, or could not be
+   rewritten (the entries read so far are then kept in memory only). */
+bool ai_cache_open(const char *path);
+
+/* Flush and close the file, rewriting it if many entries were invalidated. */
+void ai_cache_close(void);
+
+/* Copy cached result for key into out. Counts a hit or a miss. */
+bool ai_cache_lookup(uint64_t key, AiResult *out);
+
+/* Remember a remote result for student s under key. */
+void ai_cache_store(uint64_t key, const Student *s, const AiResult *r);
+
+/* Drop every entry for roll (call when the record changes or is deleted). */
+void ai_cache_invalidate_roll(int roll);
+
+void ai_cache_stats(AiCacheStats *out);
+
+/* Visit live entries in insertion order. */
+void ai_cache_foreach(void (*fn)(const AiCacheEntry *e, void *ctx), void *ctx);
+
+#endif /* AI_CACHE_H */
@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdint.h>
+#include "ai_model.h"
+#include "ai_cache.h"
+#include "columns.h"
+
+#define MODEL_MAGIC "SRMSMDL1"
+#define RISK_CLASSES 3
+#define TRAIN_EPOCHS 40
+#define TRAIN_BATCH 64
+#define TRAIN_LR 0.5f
+#define TRAIN_L2 1e-4f
+#define PREDICT_BLOCK 256
+
+static const char *const careers[AI_NUM_CAREERS] = {
+    "Computer Science", "Electronics / ECE", "Civil / Civil Eng", "Management",
+    "Arts / Humanities", "Research / Academia", "Vocational / Trade"
+};
+
+/* weights[class][feature], the last column is the bias */
+typedef struct {
+    float risk_w[RISK_CLASSES][AI_MODEL_FEATURES + 1];
+    float career_w[AI_NUM_CAREERS][AI_MODEL_FEATURES + 1];
+} Model;
+
+static Model model;
+static bool model_ready = false;  /* risk head trained or loaded */
+static bool career_ready = false; /* career head too (needs career-labelled samples) */
+
+/* Training set in feature-major order */
+typedef struct {
+    float *x;       /* n * AI_MODEL_FEATURES */
+    signed char *risk;
+    signed char *career; /* -1 when unlabelled */
+    size_t n, cap;
+} Samples;
+
+const char *ai_model_career_name(int idx) {
+    return (idx >= 0 && idx < AI_NUM_CAREERS) ? careers[idx] : "Unknown";
+}
+
+int ai_model_career_index(const char *name) {
+    if (!name) return -1;
+    for (int i = 0; i < AI_NUM_CAREERS; ++i)
+        if (strcmp(name, careers[i]) == 0) return i;
+    return -1;
+}
+
+/* Same arithmetic as the blocked roster path so both give identical predictions */
+static void make_features(const double marks[], double attendance, float *f) {
+    float mean = 0.0f, lo = 1.0f;
+    for (int i = 0; i < NUM_SUBJECTS; ++i) {
+        float v = (float)(marks[i] / 100.0);
+        f[i] = v;
+        mean += v * (1.0f / NUM_SUBJECTS);
+        if (v < lo) lo = v;
+    }
+    f[NUM_SUBJECTS] = (float)(attendance / 100.0);
+    f[NUM_SUBJECTS + 1] = mean;
+    f[NUM_SUBJECTS + 2] = lo;
+}
+
+static bool samples_add(Samples *sm, const double marks[], double attendance, int risk, int career) {
+    if (sm->n == sm->cap) {
+        size_t ncap = sm->cap ? sm->cap * 2 : 1024;
+        float *x = (float *)realloc(sm->x, ncap * AI_MODEL_FEATURES * sizeof(float));
+        if (!x) return false;
+        sm->x = x;
+        signed char *r = (signed char *)realloc(sm->risk, ncap);
+        if (!r) return false;
+        sm->risk = r;
+        signed char *c = (signed char *)realloc(sm->career, ncap);
+        if (!c) return false;
+        sm->career = c;
+        sm->cap = ncap;
+    }
+    make_features(marks, attendance, sm->x + sm->n * AI_MODEL_FEATURES);
+    sm->risk[sm->n] = (signed char)risk;
+    sm->career[sm->n] = (signed char)career;
+    ++sm->n;
+    return true;
+}
+
+static void samples_free(Samples *sm) {
+    free(sm->x);
+    free(sm->risk);
+    free(sm->career);
+    memset(sm, 0, sizeof(*sm));
+}
+
+static int argmax_logits(const float *w, int classes, const float *f, float *probs) {
+    int best = 0;
+    float mx = -INFINITY;
+    for (int c = 0; c < classes; ++c) {
+        const float *wc = w + c * (AI_MODEL_FEATURES + 1);
+        float z = wc[AI_MODEL_FEATURES];
+        for (int j = 0; j < AI_MODEL_FEATURES; ++j) z += wc[j] * f[j];
+        if (probs) probs[c] = z;
+        if (z > mx) { mx = z; best = c; }
+    }
+    if (probs) {
+        float sum = 0.0f;
+        for (int c = 0; c < classes; ++c) { probs[c] = expf(probs[c] - mx); sum += probs[c]; }
+        for (int c = 0; c < classes; ++c) probs[c] /= sum;
+    }
+    return best;
+}
+
+/* Mini-batch SGD on softmax cross-entropy; deterministic shuffling. Returns false
+   (w left zero) when no sample is labelled or memory runs out. */
+static bool train_softmax(float *w, int classes, const Samples *sm, const signed char *labels) {
+    memset(w, 0, sizeof(float) * (size_t)classes * (AI_MODEL_FEATURES + 1));
+    size_t m = 0;
+    for (size_t i = 0; i < sm->n; ++i) m += labels[i] >= 0;
+    if (m == 0) return false;
+    size_t *order = (size_t *)malloc(m * sizeof(size_t));
+    float *grad = (float *)calloc((size_t)classes * (AI_MODEL_FEATURES + 1), sizeof(float));
+    if (!order || !grad) {
+        free(order);
+        free(grad);
+        return false;
+    }
+    m = 0;
+    for (size_t i = 0; i < sm->n; ++i) if (labels[i] >= 0) order[m++] = i;
+    uint32_t rng = 12345u;
+    float probs[AI_NUM_CAREERS > RISK_CLASSES ? AI_NUM_CAREERS : RISK_CLASSES];
+    for (int epoch = 0; epoch < TRAIN_EPOCHS; ++epoch) {
+        for (size_t i = m; i > 1; --i) {
+            rng = rng * 1664525u + 1013904223u;
+            size_t j = rng % i;
+            size_t t = order[i - 1]; order[i - 1] = order[j]; order[j] = t;
+        }
+        float lr = TRAIN_LR / (1.0f + 0.1f * (float)epoch);
+        for (size_t b = 0; b < m; b += TRAIN_BATCH) {
+            size_t end = b + TRAIN_BATCH < m ? b + TRAIN_BATCH : m;
+            memset(grad, 0, sizeof(float) * (size_t)classes * (AI_MODEL_FEATURES + 1));
+            for (size_t k = b; k < end; ++k) {
+                const float *f = sm->x + order[k] * AI_MODEL_FEATURES;
+                argmax_logits(w, classes, f, probs);
+                for (int c = 0; c < classes; ++c) {
+                    float d = probs[c] - (c == labels[order[k]] ? 1.0f : 0.0f);
+                    float *gc = grad + c * (AI_MODEL_FEATURES + 1);
+                    for (int j = 0; j < AI_MODEL_FEATURES; ++j) gc[j] += d * f[j];
+                    gc[AI_MODEL_FEATURES] += d;
+                }
+            }
+            float scale = lr / (float)(end - b);
+            for (int c = 0; c < classes * (AI_MODEL_FEATURES + 1); ++c)
+                w[c] -= scale * grad[c] + lr * TRAIN_L2 * w[c];
+        }
+    }
+    free(order);
+    free(grad);
+    return true;
+}
+
+/* Train both heads; the previous model stays in place unless the risk head trains */
+static long train(const Samples *sm) {
+    Model m;
+    if (!train_softmax(&m.risk_w[0][0], RISK_CLASSES, sm, sm->risk)) return -1;
+    bool career_ok = train_softmax(&m.career_w[0][0], AI_NUM_CAREERS, sm, sm->career);
+    model = m;
+    model_ready = true;
+    career_ready = career_ok;
+    return (long)sm->n;
+}
+
+static int parse_risk(const char *t) {
+    char up[16] = {0};
+    for (int i = 0; t[i] && i < 15; ++i) up[i] = (char)toupper((unsigned char)t[i]);
+    if (strcmp(up, "LOW") == 0) return RISK_LOW;
+    if (strcmp(up, "MEDIUM") == 0) return RISK_MEDIUM;
+    if (strcmp(up, "HIGH") == 0) return RISK_HIGH;
+    return -1;
+}
+
+long ai_model_train_csv(const char *csv_path) {
+    FILE *f = fopen(csv_path, "r");
+    if (!f) return -1;
+    Samples sm;
+    memset(&sm, 0, sizeof(sm));
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        double v[NUM_SUBJECTS + 1];
+        char risk[32] = {0}, career[128] = {0};
+        int got = sscanf(line, "%lf,%lf,%lf,%lf,%lf,%lf,%31[^,\r\n],%127[^\r\n]",
+                         &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], risk, career);
+        if (got < 7) continue; /* header or malformed row */
+        int r = parse_risk(risk);
+        if (r < 0) continue;
+        if (!samples_add(&sm, v, v[NUM_SUBJECTS], r, got == 8 ? ai_model_career_index(career) : -1)) {
+            samples_free(&sm);
+            fclose(f);
+            return -1;
+        }
+    }
+    fclose(f);
+    long n = train(&sm);
+    samples_free(&sm);
+    return n;
+}
+
+typedef struct {
+    Samples sm;
+    bool failed;
+} CacheSamples;
+
+static void add_cached(const AiCacheEntry *e, void *ctx) {
+    CacheSamples *cs = (CacheSamples *)ctx;
+    if (cs->failed) return;
+    if (!samples_add(&cs->sm, e->marks, e->attendance, (int)e->result.risk, ai_model_career_index(e->result.career)))
+        cs->failed = true;
+}
+
+long ai_model_train_from_cache(void) {
+    CacheSamples cs;
+    memset(&cs, 0, sizeof(cs));
+    ai_cache_foreach(add_cached, &cs);
+    long n = cs.failed ? -1 : train(&cs.sm);
+    samples_free(&cs.sm);
+    return n;
+}
+
+bool ai_model_load(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return false;
+    char magic[8];
+    uint32_t dims[3];
+    Model m;
+    bool ok = fread(magic, 1, 8, f) == 8 && memcmp(magic, MODEL_MAGIC, 8) == 0 &&
+              fread(dims, sizeof(dims), 1, f) == 1 &&
+              dims[0] == AI_MODEL_FEATURES && dims[1] == RISK_CLASSES &&
+              (dims[2] == AI_NUM_CAREERS || dims[2] == 0) && fread(&m, sizeof(m), 1, f) == 1;
+    fclose(f);
+    if (!ok) return false;
+    model = m;
+    model_ready = true;
+    career_ready = dims[2] != 0;
+    return true;
+}
+
+bool ai_model_save(const char *path) {
+    if (!model_ready) return false;
+    FILE *f = fopen(path, "wb");
+    if (!f) return false;
+    /* a career count of 0 marks an untrained career head */
+    uint32_t dims[3] = { AI_MODEL_FEATURES, RISK_CLASSES, career_ready ? AI_NUM_CAREERS : 0 };
+    bool ok = fwrite(MODEL_MAGIC, 1, 8, f) == 8 && fwrite(dims, sizeof(dims), 1, f) == 1 &&
+              fwrite(&model, sizeof(model), 1, f) == 1;
+    if (fclose(f) != 0) ok = false;
+    return ok;
+}
+
+bool ai_model_loaded(void) {
+    return model_ready;
+}
+
+bool ai_model_predict(const Student *s, RiskLevel *risk, int *career) {
+    if (!model_ready || !s) return false;
+    float f[AI_MODEL_FEATURES];
+    make_features(s->marks, s->attendance, f);
+    if (risk) *risk = (RiskLevel)argmax_logits(&model.risk_w[0][0], RISK_CLASSES, f, NULL);
+    if (career) *career = career_ready ? argmax_logits(&model.career_w[0][0], AI_NUM_CAREERS, f, NULL) : -1;
+    return true;
+}
+
+/* argmax over classes for one block; feature-major inputs so the inner loops vectorize */
+static void predict_block(const float *w, int classes, float feat[][PREDICT_BLOCK], size_t len, unsigned char *out) {
+    float best[PREDICT_BLOCK], z[PREDICT_BLOCK];
+    for (int c = 0; c < classes; ++c) {
+        const float *wc = w + c * (AI_MODEL_FEATURES + 1);
+        for (size_t i = 0; i < len; ++i) z[i] = wc[AI_MODEL_FEATURES];
+        for (int j = 0; j < AI_MODEL_FEATURES; ++j) {
+            const float wj = wc[j];
+            const float *fj = feat[j];
+            for (size_t i = 0; i < len; ++i) z[i] += wj * fj[i];
+        }
+        for (size_t i = 0; i < len; ++i) {
+            if (c == 0 || z[i] > best[i]) {
+                best[i] = z[i];
+                out[i] = (unsigned char)c;
+            }
+        }
+    }
+}
+
+bool ai_model_predict_roster(unsigned char *risk, unsigned char *career) {
+    if (!model_ready || (career && !career_ready)) return false;
+    size_t n = col_count();
+    const double *cols[COL_COUNT];
+    for (int c = 0; c < COL_COUNT; ++c) cols[c] = col_data(c);
+    float feat[AI_MODEL_FEATURES][PREDICT_BLOCK];
+    for (size_t base = 0; base < n; base += PREDICT_BLOCK) {
+        size_t len = n - base < PREDICT_BLOCK ? n - base : PREDICT_BLOCK;
+        for (size_t i = 0; i < len; ++i) {
+            feat[NUM_SUBJECTS + 1][i] = 0.0f;
+            feat[NUM_SUBJECTS + 2][i] = 1.0f;
+        }
+        for (int j = 0; j < NUM_SUBJECTS; ++j) {
+            const double *x = cols[j] + base;
+            for (size_t i = 0; i < len; ++i) {
+                float v = (float)(x[i] / 100.0);
+                feat[j][i] = v;
+                feat[NUM_SUBJECTS + 1][i] += v * (1.0f / NUM_SUBJECTS);
+                if (v < feat[NUM_SUBJECTS + 2][i]) feat[NUM_SUBJECTS + 2][i] = v;
+            }
+        }
+        const double *att = cols[COL_ATTENDANCE] + base;
+        for (size_t i = 0; i < len; ++i) feat[NUM_SUBJECTS][i] = (float)(att[i] / 100.0);
+        if (risk) predict_block(&model.risk_w[0][0], RISK_CLASSES, feat, len, risk + base);
+        if (career) predict_block(&model.career_w[0][0], AI_NUM_CAREERS, feat, len, career + base);
+    }
+    return true;
+}
+
+static void compare_cached(const AiCacheEntry *e, void *ctx) {
+    AiModelAgreement *a = (AiModelAgreement *)ctx;
+    float f[AI_MODEL_FEATURES];
+    make_features(e->marks, e->attendance, f);
+    ++a->samples;
+    if (argmax_logits(&model.risk_w[0][0], RISK_CLASSES, f, NULL) == (int)e->result.risk) ++a->risk_agree;
+    int want = ai_model_career_index(e->result.career);
+    if (want >= 0 && career_ready) {
+        ++a->career_samples;
+        if (argmax_logits(&model.career_w[0][0], AI_NUM_CAREERS, f, NULL) == want) ++a->career_agree;
+    }
+}
+
+bool ai_model_agreement(AiModelAgreement *out) {
+    if (!out) return false;
+    memset(out, 0, sizeof(*out));
+    if (!model_ready) return false;
+    ai_cache_foreach(compare_cached, out);
+    return true;
+}
@@ -0,0 +1,57 @@
+#ifndef AI_MODEL_H
+#define AI_MODEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "student.h"
+#include "openai_ai.h"
+
+/* Small in-process model used when the remote AI is unavailable.
+   Two multinomial logistic regressions (risk: 3 classes, career: AI_NUM_CAREERS classes)
+   over the five marks, attendance, mean mark and lowest mark, trained offline from
+   labelled CSV or from cached remote answers and stored in a compact binary file. */
+
+#define AI_MODEL_FEATURES 8
+#define AI_NUM_CAREERS 7
+
+/* Load/save the model file. Load returns false if absent or malformed. */
+bool ai_model_load(const char *path);
+bool ai_model_save(const char *path);
+
+/* True once a model was loaded or trained. */
+bool ai_model_loaded(void);
+
+/* Train from CSV rows "math,physics,chemistry,cs,english,attendance,risk[,career]"
+   (risk LOW/MEDIUM/HIGH, career one of the allowed names; a header row is skipped).
+   Returns the number of samples used, or -1 on error (unreadable file, no usable
+   row, out of memory), leaving the previous model in place. The career head is
+   trained only when some rows name an allowed career. */
+long ai_model_train_csv(const char *csv_path);
+
+/* Train from the remote answers kept in the AI result cache. Same return value. */
+long ai_model_train_from_cache(void);
+
+/* Predict one student. Returns false if no model is loaded; *career is -1 when the
+   model has no trained career head. */
+bool ai_model_predict(const Student *s, RiskLevel *risk, int *career);
+
+/* Predict every row of the columnar store (columns.h) in blocks; risk and career
+   must hold col_count() entries. Returns false if no model is loaded, or career is
+   requested and the model has no trained career head. */
+bool ai_model_predict_roster(unsigned char *risk, unsigned char *career);
+
+/* Allowed career buckets (same list as the remote prompt). */
+const char *ai_model_career_name(int idx);
+int ai_model_career_index(const char *name); /* -1 if not an allowed name */
+
+/* Agreement between the local model and the remote answers in the AI cache */
+typedef struct {
+    size_t samples;
+    size_t risk_agree;
+    size_t career_samples; /* cached answers whose career is an allowed name */
+    size_t career_agree;
+} AiModelAgreement;
+
+bool ai_model_agreement(AiModelAgreement *out);
+
+#endif /* AI_MODEL_H */
@@ -0,0 +1,274 @@
+/* Benchmark driver for the database layer (separate program, see README).
+   Builds synthetic rosters of 10^3 .. 10^7 students from a seeded generator,
+   times the main database operations at each size and prints JSON results. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include "student.h"
+#include "database.h"
+#include "storage.h"
+#include "record.h"
+
+#define BENCH_DEFAULT_MAX 10000000
+#define BENCH_SAMPLE_OPS 100000 /* cap on per-size lookups/deletes/journaled adds */
+
+/* --- deterministic generator --- */
+
+static uint64_t rng_state;
+
+static uint64_t rng_next(void) {
+    /* splitmix64: fixed output for a given seed on every platform */
+    uint64_t z = (rng_state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double rng_unit(void) {
+    return (double)(rng_next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Approximately normal: sum of four uniforms (Irwin-Hall), scaled */
+static double rng_normal(double mean, double sd) {
+    double s = rng_unit() + rng_unit() + rng_unit() + rng_unit() - 2.0;
+    return mean + sd * s * 1.7320508075688772; /* var of the sum is 1/3 */
+}
+
+static double clamp_half(double v) {
+    if (v < 0.0) v = 0.0;
+    if (v > 100.0) v = 100.0;
+    return floor(v * 2.0 + 0.5) / 2.0; /* marks are entered in half points */
+}
+
+static const char *first_names[] = {
+    "Aarav", "Ananya", "Li", "Maria", "Mohammed", "Olivia", "Noah", "Sofia", "Yuki", "Arjun",
+    "Chiamaka", "Mateo", "Priya", "Jean-Baptiste", "Zoe", "Oluwaseun", "Anastasia", "Kai", "Ishaan", "Fatima"
+};
+static const char *last_names[] = {
+    "Kandwal", "Sharma", "Wang", "Garcia", "Khan", "Smith", "Nguyen", "Okonkwo", "Tanaka", "Muller",
+    "Fernandez-Lopez", "Ivanova", "Brown", "Chatterjee", "Kowalski", "Andersson", "Rossi", "Dubois", "Haddad", "Bose"
+};
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+/* Name, marks and attendance for one generated student */
+static void gen_student(int roll, char *name, double marks[], double *attendance) {
+    const char *f = first_names[rng_next() % COUNT_OF(first_names)];
+    const char *l = last_names[rng_next() % COUNT_OF(last_names)];
+    /* about one in four names carries a middle initial; a numeric suffix keeps most names distinct */
+    if (rng_next() % 4 == 0)
+        snprintf(name, NAME_LEN, "%s %c. %s %d", f, (char)('A' + rng_next() % 26), l, roll % 1000);
+    else
+        snprintf(name, NAME_LEN, "%s %s %d", f, l, roll % 1000);
+    double ability = rng_normal(65.0, 12.0);
+    for (int i = 0; i < NUM_SUBJECTS; ++i) marks[i] = clamp_half(rng_normal(ability, 9.0));
+    /* attendance is skewed towards the top: most students above 80% */
+    *attendance = clamp_half(100.0 - fabs(rng_normal(0.0, 14.0)));
+}
+
+/* --- timing and output --- */
+
+static double now_sec(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static FILE *json_out;
+static bool json_first = true;
+
+static void report(size_t n, const char *op, size_t ops, double secs) {
+    fprintf(json_out, "%s\n    {\"n\": %zu, \"op\": \"%s\", \"ops\": %zu, \"seconds\": %.6f, \"ns_per_op\": %.1f}",
+            json_first ? "" : ",", n, op, ops, secs, ops ? secs * 1e9 / (double)ops : 0.0);
+    json_first = false;
+    fprintf(stderr, "  n=%-9zu %-20s %10zu ops %10.4f s\n", n, op, ops, secs);
+}
+
+/* A size (snapshot file, resident records) instead of a timing */
+static void report_bytes(size_t n, const char *what, long long bytes) {
+    fprintf(json_out, "%s\n    {\"n\": %zu, \"op\": \"%s\", \"bytes\": %lld, \"bytes_per_record\": %.1f}",
+            json_first ? "" : ",", n, what, bytes, n ? (double)bytes / (double)n : 0.0);
+    json_first = false;
+    fprintf(stderr, "  n=%-9zu %-20s %10lld bytes\n", n, what, bytes);
+}
+
+static uint64_t gcd_u64(uint64_t a, uint64_t b) {
+    while (b) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+static size_t perm_n = 0;
+static uint64_t perm_step = 1;
+
+/* Roll of the k-th generated student: rolls 1, 8, 15, ... visited in a scrambled
+   but fixed order (k * step mod n with step coprime to n is a permutation) */
+static int roll_at(size_t k, size_t n) {
+    if (perm_n != n) {
+        perm_n = n;
+        perm_step = 2654435761ULL % n;
+        while (perm_step < 2 || gcd_u64(perm_step, n) != 1) ++perm_step;
+    }
+    return (int)(((uint64_t)k * perm_step) % n) * 7 + 1;
+}
+
+static void discard_stdout_begin(int *saved) {
+    fflush(stdout);
+    *saved = dup(1);
+    int devnull = open("/dev/null", O_WRONLY);
+    dup2(devnull, 1);
+    close(devnull);
+}
+
+static void discard_stdout_end(int saved) {
+    fflush(stdout);
+    dup2(saved, 1);
+    close(saved);
+}
+
+static void bench_size(size_t n, const char *path) {
+    char jpath[600];
+    snprintf(jpath, sizeof(jpath), "%s.journal", path);
+    remove(path);
+    remove(jpath);
+    if (!db_load(path)) {
+        fprintf(stderr, "cannot open %s\n", path);
+        exit(1);
+    }
+    size_t sample = n < BENCH_SAMPLE_OPS ? n : BENCH_SAMPLE_OPS;
+
+    /* add: whole roster, as a bulk import would (no per-add journal flush) */
+    char name[NAME_LEN];
+    double marks[NUM_SUBJECTS], att;
+    double t = now_sec();
+    db_bulk_begin();
+    for (size_t k = 0; k < n; ++k) {
+        int roll = roll_at(k, n);
+        gen_student(roll, name, marks, &att);
+        Student *s = create_student(name, roll, marks, att);
+        if (!s || !db_add_student(s)) {
+            fprintf(stderr, "add failed at %zu\n", k);
+            exit(1);
+        }
+    }
+    report(n, "add", n, now_sec() - t);
+    report_bytes(n, "resident", (long long)record_memory());
+
+    t = now_sec();
+    if (!db_bulk_end()) { fprintf(stderr, "save failed\n"); exit(1); } /* saves to path */
+    report(n, "save", n, now_sec() - t);
+    struct stat st;
+    report_bytes(n, "file_size", stat(path, &st) == 0 ? (long long)st.st_size : -1);
+
+    t = now_sec();
+    if (!db_load(path)) { fprintf(stderr, "load failed\n"); exit(1); }
+    report(n, "load", n, now_sec() - t);
+
+    /* add_journaled: interactive-style adds, one journal append each */
+    t = now_sec();
+    for (size_t k = 0; k < sample; ++k) {
+        int roll = (int)(n * 7 + 1 + k * 7 + 3); /* outside the roster's rolls */
+        gen_student(roll, name, marks, &att);
+        Student *s = create_student(name, roll, marks, att);
+        if (!s || !db_add_student(s)) free_student(s);
+    }
+    report(n, "add_journaled", sample, now_sec() - t);
+
+    /* search_by_roll: random hits, then misses */
+    volatile size_t found = 0;
+    t = now_sec();
+    for (size_t k = 0; k < sample; ++k) found += db_search_by_roll(roll_at(rng_next() % n, n)) != NULL;
+    report(n, "search_by_roll", sample, now_sec() - t);
+    t = now_sec();
+    for (size_t k = 0; k < sample; ++k) found += db_search_by_roll(roll_at(rng_next() % n, n) + 1) != NULL;
+    report(n, "search_by_roll_miss", sample, now_sec() - t);
+
+    /* search_by_name: names of existing students */
+    size_t qn = sample < 10000 ? sample : 10000;
+    char (*queries)[NAME_LEN] = malloc((size_t)qn * NAME_LEN);
+    if (queries) {
+        for (size_t k = 0; k < qn; ++k) {
+            const Student *s = db_search_by_roll(roll_at(rng_next() % n, n));
+            snprintf(queries[k], NAME_LEN, "%s", s ? s->name : "nobody");
+        }
+        t = now_sec();
+        for (size_t k = 0; k < qn; ++k) found += db_search_by_name(queries[k]) != NULL;
+        report(n, "search_by_name", qn, now_sec() - t);
+        free(queries);
+    }
+
+    /* print_all: full listing into /dev/null */
+    int saved;
+    discard_stdout_begin(&saved);
+    t = now_sec();
+    db_print_all();
+    double secs = now_sec() - t;
+    discard_stdout_end(saved);
+    report(n, "print_all", db_count(), secs);
+
+    /* delete: random existing rolls (journaled) */
+    t = now_sec();
+    size_t deleted = 0;
+    for (size_t k = 0; k < sample; ++k) deleted += db_delete_by_roll(roll_at((k * 7919) % n, n));
+    report(n, "delete", sample, now_sec() - t);
+    if (found == (size_t)-1 || deleted == (size_t)-1) fprintf(stderr, "unreachable\n");
+
+    db_free_all();
+    remove(path);
+    remove(jpath);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--max N] [--min N] [--seed S] [--out FILE] [--file DBFILE] [--no-compress]\n"
+                    "       [--threads N]\n"
+                    "Sizes run from --min (default 1000) to --max (default %d) in powers of ten.\n"
+                    "--no-compress writes snapshot blocks without LZ compression.\n"
+                    "--threads sets the snapshot encode/decode threads (default: one per CPU).\n",
+            prog, BENCH_DEFAULT_MAX);
+}
+
+int main(int argc, char **argv) {
+    size_t min_n = 1000, max_n = BENCH_DEFAULT_MAX;
+    uint64_t seed = 42;
+    const char *out_path = NULL, *db_file = "bench_students.dat";
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 < argc && strcmp(argv[i], "--max") == 0) max_n = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (i + 1 < argc && strcmp(argv[i], "--min") == 0) min_n = (size_t)strtoull(argv[++i], NULL, 10);
+        else if (i + 1 < argc && strcmp(argv[i], "--seed") == 0) seed = strtoull(argv[++i], NULL, 10);
+        else if (i + 1 < argc && strcmp(argv[i], "--out") == 0) out_path = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--file") == 0) db_file = argv[++i];
+        else if (strcmp(argv[i], "--no-compress") == 0) storage_set_compression(false);
+        else if (i + 1 < argc && strcmp(argv[i], "--threads") == 0) storage_set_threads(atoi(argv[++i]));
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (min_n < 10 || max_n < min_n || max_n > 100000000) {
+        usage(argv[0]);
+        return 1;
+    }
+    json_out = out_path ? fopen(out_path, "w") : stdout;
+    if (!json_out) {
+        fprintf(stderr, "cannot write %s\n", out_path);
+        return 1;
+    }
+    fprintf(json_out, "{\n  \"benchmark\": \"srms-db\",\n  \"seed\": %llu,\n  \"record_bytes\": %zu,\n  \"results\": [",
+            (unsigned long long)seed, sizeof(Record));
+    for (size_t n = min_n; n <= max_n; n *= 10) {
+        rng_state = seed ^ (uint64_t)n; /* each size is reproducible on its own */
+        bench_size(n, db_file);
+        fflush(json_out);
+    }
+    fprintf(json_out, "\n  ]\n}\n");
+    if (out_path) fclose(json_out);
+    return 0;
+}
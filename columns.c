@@ -0,0 +1,268 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "columns.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static size_t col_n = 0;
+static size_t col_cap = 0;
+static int *col_roll = NULL;
+static double *col_vals[COL_COUNT] = {NULL};
+
+static bool col_bits_on = false;
+static uint64_t *col_bits[COL_COUNT][COL_BUCKETS]; /* col_cap / 64 words each when on */
+
+#define BIT_WORDS(n) (((n) + 63) / 64)
+
+static bool bits_reserve(size_t cap) {
+    for (int c = 0; c < COL_COUNT; ++c) {
+        for (int b = 0; b < COL_BUCKETS; ++b) {
+            uint64_t *w = (uint64_t *)realloc(col_bits[c][b], BIT_WORDS(cap) * sizeof(uint64_t));
+            if (!w) return false;
+            /* rows at or beyond col_n never have a bit set */
+            size_t used = BIT_WORDS(col_n);
+            if (col_bits[c][b] == NULL) used = 0;
+            memset(w + used, 0, (BIT_WORDS(cap) - used) * sizeof(uint64_t));
+            col_bits[c][b] = w;
+        }
+    }
+    return true;
+}
+
+static void bits_free(void) {
+    for (int c = 0; c < COL_COUNT; ++c) {
+        for (int b = 0; b < COL_BUCKETS; ++b) {
+            free(col_bits[c][b]);
+            col_bits[c][b] = NULL;
+        }
+    }
+}
+
+static void bits_put(int column, size_t row, bool set) {
+    uint64_t *w = col_bits[column][col_bucket_of(col_vals[column][row])] + row / 64;
+    uint64_t bit = (uint64_t)1 << (row % 64);
+    if (set) *w |= bit;
+    else *w &= ~bit;
+}
+
+static void bits_put_row(size_t row, bool set) {
+    if (!col_bits_on) return;
+    for (int c = 0; c < COL_COUNT; ++c) bits_put(c, row, set);
+}
+
+static bool col_reserve(size_t need) {
+    if (need <= col_cap) return true;
+    size_t ncap = col_cap ? col_cap * 2 : 1024;
+    while (ncap < need) ncap *= 2;
+    int *r = (int *)realloc(col_roll, ncap * sizeof(int));
+    if (!r) return false;
+    col_roll = r;
+    for (int c = 0; c < COL_COUNT; ++c) {
+        double *v = (double *)realloc(col_vals[c], ncap * sizeof(double));
+        if (!v) return false; /* arrays already grown keep working with the old count */
+        col_vals[c] = v;
+    }
+    if (col_bits_on && !bits_reserve(ncap)) return false;
+    col_cap = ncap;
+    return true;
+}
+
+size_t col_append(int roll, const double marks[], double attendance) {
+    if (!col_reserve(col_n + 1)) return (size_t)-1;
+    size_t row = col_n++;
+    col_roll[row] = roll;
+    for (int i = 0; i < NUM_SUBJECTS; ++i) col_vals[i][row] = marks[i];
+    col_vals[COL_ATTENDANCE][row] = attendance;
+    bits_put_row(row, true);
+    return row;
+}
+
+void col_set(size_t row, const double marks[], double attendance) {
+    bits_put_row(row, false);
+    for (int i = 0; i < NUM_SUBJECTS; ++i) col_vals[i][row] = marks[i];
+    col_vals[COL_ATTENDANCE][row] = attendance;
+    bits_put_row(row, true);
+}
+
+bool col_remove(size_t row, int *moved_roll) {
+    size_t last = col_n - 1;
+    bits_put_row(row, false);
+    if (row == last) {
+        --col_n;
+        return false;
+    }
+    bits_put_row(last, false);
+    col_roll[row] = col_roll[last];
+    for (int c = 0; c < COL_COUNT; ++c) col_vals[c][row] = col_vals[c][last];
+    bits_put_row(row, true);
+    --col_n;
+    *moved_roll = col_roll[row];
+    return true;
+}
+
+void col_clear(void) {
+    bits_free();
+    free(col_roll);
+    col_roll = NULL;
+    for (int c = 0; c < COL_COUNT; ++c) {
+        free(col_vals[c]);
+        col_vals[c] = NULL;
+    }
+    col_n = col_cap = 0;
+}
+
+size_t col_count(void) {
+    return col_n;
+}
+
+const double *col_data(int column) {
+    if (column < 0 || column >= COL_COUNT) return NULL;
+    return col_vals[column];
+}
+
+const int *col_rolls(void) {
+    return col_roll;
+}
+
+int col_bucket_of(double value) {
+    if (!(value >= COL_BUCKET_WIDTH)) return 0; /* also NaN */
+    if (value >= COL_BUCKET_WIDTH * (COL_BUCKETS - 1)) return COL_BUCKETS - 1;
+    int b = (int)(value / COL_BUCKET_WIDTH);
+    /* the division may round across a bucket edge; settle on the exact bounds */
+    if (value < b * COL_BUCKET_WIDTH) --b;
+    else if (value >= (b + 1) * COL_BUCKET_WIDTH) ++b;
+    return b;
+}
+
+bool col_buckets_enable(bool on) {
+    if (!on) {
+        bits_free();
+        col_bits_on = false;
+        return true;
+    }
+    if (col_bits_on) return true;
+    if (col_cap > 0 && !bits_reserve(col_cap)) {
+        bits_free();
+        return false;
+    }
+    col_bits_on = true;
+    for (size_t row = 0; row < col_n; ++row) bits_put_row(row, true);
+    return true;
+}
+
+bool col_buckets_enabled(void) {
+    return col_bits_on;
+}
+
+const uint64_t *col_bucket_bitmap(int column, int bucket) {
+    if (!col_bits_on || column < 0 || column >= COL_COUNT || bucket < 0 || bucket >= COL_BUCKETS) return NULL;
+    return col_bits[column][bucket];
+}
+
+/* One pass over a column: sum, sum of squares, min, max */
+static void kernel_moments(const double *x, size_t n, double *sum, double *sumsq, double *mn, double *mx) {
+    size_t i = 0;
+    double s = 0.0, q = 0.0, lo = x[0], hi = x[0];
+#if defined(__AVX__)
+    __m256d vs = _mm256_setzero_pd(), vq = _mm256_setzero_pd();
+    __m256d vlo = _mm256_set1_pd(lo), vhi = vlo;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v = _mm256_loadu_pd(x + i);
+        vs = _mm256_add_pd(vs, v);
+        vq = _mm256_add_pd(vq, _mm256_mul_pd(v, v));
+        vlo = _mm256_min_pd(vlo, v);
+        vhi = _mm256_max_pd(vhi, v);
+    }
+    double ts[4], tq[4], tl[4], th[4];
+    _mm256_storeu_pd(ts, vs); _mm256_storeu_pd(tq, vq);
+    _mm256_storeu_pd(tl, vlo); _mm256_storeu_pd(th, vhi);
+    for (int k = 0; k < 4; ++k) {
+        s += ts[k]; q += tq[k];
+        if (tl[k] < lo) lo = tl[k];
+        if (th[k] > hi) hi = th[k];
+    }
+#elif defined(__SSE2__)
+    __m128d vs = _mm_setzero_pd(), vq = _mm_setzero_pd();
+    __m128d vlo = _mm_set1_pd(lo), vhi = vlo;
+    for (; i + 2 <= n; i += 2) {
+        __m128d v = _mm_loadu_pd(x + i);
+        vs = _mm_add_pd(vs, v);
+        vq = _mm_add_pd(vq, _mm_mul_pd(v, v));
+        vlo = _mm_min_pd(vlo, v);
+        vhi = _mm_max_pd(vhi, v);
+    }
+    double ts[2], tq[2], tl[2], th[2];
+    _mm_storeu_pd(ts, vs); _mm_storeu_pd(tq, vq);
+    _mm_storeu_pd(tl, vlo); _mm_storeu_pd(th, vhi);
+    for (int k = 0; k < 2; ++k) {
+        s += ts[k]; q += tq[k];
+        if (tl[k] < lo) lo = tl[k];
+        if (th[k] > hi) hi = th[k];
+    }
+#endif
+    for (; i < n; ++i) {
+        s += x[i];
+        q += x[i] * x[i];
+        if (x[i] < lo) lo = x[i];
+        if (x[i] > hi) hi = x[i];
+    }
+    *sum = s; *sumsq = q; *mn = lo; *mx = hi;
+}
+
+bool col_summary(int column, ColumnSummary *out) {
+    if (column < 0 || column >= COL_COUNT || !out) return false;
+    memset(out, 0, sizeof(*out));
+    if (col_n == 0) return true;
+    kernel_moments(col_vals[column], col_n, &out->sum, &out->sumsq, &out->min, &out->max);
+    out->count = col_n;
+    out->mean = out->sum / (double)col_n;
+    double var = out->sumsq / (double)col_n - out->mean * out->mean;
+    out->stddev = var > 0.0 ? sqrt(var) : 0.0;
+    return true;
+}
+
+bool col_histogram(int column, double lo, double hi, int bins, size_t *counts) {
+    if (column < 0 || column >= COL_COUNT || bins <= 0 || !counts || !(hi > lo)) return false;
+    /* four sub-histograms so consecutive increments rarely hit the same counter */
+    size_t *sub = (size_t *)calloc((size_t)bins * 4, sizeof(size_t));
+    if (!sub) return false;
+    const double *x = col_vals[column];
+    const double scale = (double)bins / (hi - lo);
+    const int top = bins - 1;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128d vlo = _mm_set1_pd(lo), vscale = _mm_set1_pd(scale);
+    const __m128d vzero = _mm_setzero_pd(), vtop = _mm_set1_pd((double)top);
+    for (; i + 4 <= col_n; i += 4) {
+        /* bin = clamp((x - lo) * scale, 0, top), converted by truncation */
+        __m128d a = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(x + i), vlo), vscale);
+        __m128d b = _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(x + i + 2), vlo), vscale);
+        a = _mm_min_pd(_mm_max_pd(a, vzero), vtop);
+        b = _mm_min_pd(_mm_max_pd(b, vzero), vtop);
+        int idx[4];
+        __m128i ia = _mm_cvttpd_epi32(a), ib = _mm_cvttpd_epi32(b);
+        idx[0] = _mm_cvtsi128_si32(ia);
+        idx[1] = _mm_cvtsi128_si32(_mm_srli_si128(ia, 4));
+        idx[2] = _mm_cvtsi128_si32(ib);
+        idx[3] = _mm_cvtsi128_si32(_mm_srli_si128(ib, 4));
+        ++sub[idx[0]];
+        ++sub[(size_t)bins + (size_t)idx[1]];
+        ++sub[2 * (size_t)bins + (size_t)idx[2]];
+        ++sub[3 * (size_t)bins + (size_t)idx[3]];
+    }
+#endif
+    for (; i < col_n; ++i) {
+        double f = (x[i] - lo) * scale;
+        int b = f <= 0.0 ? 0 : (f >= (double)top ? top : (int)f);
+        ++sub[b];
+    }
+    for (int b = 0; b < bins; ++b)
+        counts[b] = sub[b] + sub[bins + b] + sub[2 * bins + b] + sub[3 * bins + b];
+    free(sub);
+    return true;
+}
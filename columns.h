@@ -0,0 +1,79 @@
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include "student.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Columnar (struct-of-arrays) shadow of the marks and attendance of every student.
+   database.c keeps it in sync on add/update/delete/load; rows are dense and
+   unordered (a delete moves the last row into the hole). */
+
+/* Column ids: 0..NUM_SUBJECTS-1 are the subjects in student.h order */
+#define COL_ATTENDANCE NUM_SUBJECTS
+#define COL_COUNT (NUM_SUBJECTS + 1)
+
+/* Per-column summary over the whole class (population standard deviation) */
+typedef struct {
+    size_t count;
+    double mean;
+    double min;
+    double max;
+    double stddev;
+    double sum;   /* raw moments, for callers keeping running totals */
+    double sumsq;
+} ColumnSummary;
+
+/* --- maintenance (used by database.c) --- */
+
+/* Append a row; returns its index or (size_t)-1 on allocation failure. */
+size_t col_append(int roll, const double marks[], double attendance);
+
+/* Overwrite a row's values. */
+void col_set(size_t row, const double marks[], double attendance);
+
+/* Remove row by moving the last row into it. Returns true and sets *moved_roll
+   to the roll now stored at row, or false if row was the last one (nothing moved). */
+bool col_remove(size_t row, int *moved_roll);
+
+/* Drop every row and release the arrays. */
+void col_clear(void);
+
+/* --- read access --- */
+
+size_t col_count(void);
+
+/* Contiguous array of col_count() values for a column id, roll array for col_rolls. */
+const double *col_data(int column);
+const int *col_rolls(void);
+
+/* --- bucketed bitmap index (optional, off until enabled) --- */
+
+/* Each column is split into value buckets [0,10), [10,20), ..., [90,100) and
+   [100,inf); bucket 0 also takes anything below 10. Per bucket one bit per row. */
+#define COL_BUCKETS 11
+#define COL_BUCKET_WIDTH 10.0
+
+/* Build (on == true) or drop the bitmaps; once built they follow every
+   append/set/remove. Returns false if the bitmaps could not be allocated. */
+bool col_buckets_enable(bool on);
+bool col_buckets_enabled(void);
+
+/* Bucket a value falls into. */
+int col_bucket_of(double value);
+
+/* Bitmap of the rows in a bucket ((col_count() + 63) / 64 words, bit r % 64 of
+   word r / 64), or NULL when the index is disabled or arguments are invalid. */
+const uint64_t *col_bucket_bitmap(int column, int bucket);
+
+/* --- class-wide analytics (SSE2/AVX when compiled in, scalar otherwise) --- */
+
+/* Returns false for an unknown column. An empty class yields count 0 and zeros. */
+bool col_summary(int column, ColumnSummary *out);
+
+/* Count values into bins equal-width bins over [lo, hi]; values outside are
+   clamped into the first/last bin. counts must hold bins entries. */
+bool col_histogram(int column, double lo, double hi, int bins, size_t *counts);
+
+#endif /* COLUMNS_H */
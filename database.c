@@ -1,175 +1,1081 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
 #include "database.h"
 #include "student.h"   // ensure print_student / student_average prototypes are available
+#include "journal.h"
+#include "storage.h"
+#include "columns.h"
+#include "name_index.h"
+#include "roll_order.h"
+#include "mvcc.h"
+#include "record.h"
+#include "metrics.h"
 
-static Student *db_head = NULL; /* internal linked list head */
+/* Journal is folded into a new snapshot once it outgrows the snapshot itself
+   (amortized O(1) per mutation), but never below this size. */
+#define JOURNAL_MIN_COMPACT_BYTES (1L << 20)
 
-/* comparator for qsort: ascending by roll using pointers */
-static int cmp_ptr_roll_asc(const void *a, const void *b) {
-    const Student *const *pa = (const Student *const *)a;
-    const Student *const *pb = (const Student *const *)b;
-    if ((*pa)->roll < (*pb)->roll) return -1;
-    if ((*pa)->roll > (*pb)->roll) return 1;
-    return 0;
+static Record *db_head = NULL; /* internal linked list head (compact records, see record.h) */
+
+static char db_path[512] = "";      /* snapshot file the journal belongs to */
+static long db_snapshot_bytes = 0;  /* size of that snapshot when last written/read */
+static long db_record_bytes = 40;   /* encoded size of a record in the last snapshot */
+static bool db_journal_failed = false;
+static bool db_bulk = false;        /* bulk mode: mutations are not journaled */
+static DbChangeHook db_change_hook = NULL;
+static bool snap_on = false;        /* versions are kept for db_snapshot_open */
+
+/* Open-addressing hash index on roll (linear probing, backward-shift delete).
+   Each slot also remembers the list predecessor of its node so unlinking is O(1). */
+typedef struct {
+    Record *node; /* NULL marks an empty slot */
+    Record *prev; /* predecessor in db_head list, NULL when node is the head */
+    size_t row;    /* row in the columnar shadow store (columns.h) */
+} RollSlot;
+
+#define ROLL_INDEX_MIN_CAP 64
+
+static RollSlot *roll_index = NULL;
+static size_t roll_index_cap = 0;   /* always a power of two */
+static size_t roll_index_count = 0;
+
+static size_t roll_hash(int roll) {
+    unsigned int x = (unsigned int)roll;
+    x ^= x >> 16; x *= 0x7feb352dU;
+    x ^= x >> 15; x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return (size_t)x;
+}
+
+/* Return slot holding roll, or NULL */
+static RollSlot *roll_index_find(int roll) {
+    if (!roll_index) return NULL;
+    size_t mask = roll_index_cap - 1;
+    for (size_t i = roll_hash(roll) & mask;; i = (i + 1) & mask) {
+        if (!roll_index[i].node) return NULL;
+        if (roll_index[i].node->roll == roll) return &roll_index[i];
+    }
+}
+
+static void roll_index_place(RollSlot *tab, size_t cap, RollSlot e) {
+    size_t mask = cap - 1;
+    size_t i = roll_hash(e.node->roll) & mask;
+    while (tab[i].node) i = (i + 1) & mask;
+    tab[i] = e;
+}
+
+/* Rehash into a table with room for n entries at load factor <= 0.5 */
+static bool roll_index_reserve(size_t n) {
+    size_t ncap = roll_index_cap ? roll_index_cap : ROLL_INDEX_MIN_CAP;
+    while (ncap / 2 < n) ncap *= 2;
+    if (ncap == roll_index_cap) return true;
+    RollSlot *ntab = (RollSlot *)calloc(ncap, sizeof(RollSlot));
+    if (!ntab) return false;
+    for (size_t i = 0; i < roll_index_cap; ++i)
+        if (roll_index[i].node) roll_index_place(ntab, ncap, roll_index[i]);
+    free(roll_index);
+    roll_index = ntab;
+    roll_index_cap = ncap;
+    return true;
+}
+
+/* Insert a node that is not yet indexed (keeps load factor <= 0.5) */
+static bool roll_index_insert(Record *node, Record *prev, size_t row) {
+    if ((roll_index_count + 1) * 2 > roll_index_cap && !roll_index_reserve(roll_index_count + 1)) return false;
+    RollSlot e = { node, prev, row };
+    roll_index_place(roll_index, roll_index_cap, e);
+    ++roll_index_count;
+    return true;
+}
+
+/* Remove slot, shifting back later entries of the probe run so lookups need no tombstones */
+static void roll_index_remove(RollSlot *slot) {
+    size_t mask = roll_index_cap - 1;
+    size_t hole = (size_t)(slot - roll_index);
+    size_t i = hole;
+    while (1) {
+        i = (i + 1) & mask;
+        if (!roll_index[i].node) break;
+        size_t home = roll_hash(roll_index[i].node->roll) & mask;
+        /* entry at i may move into the hole only if its home is not in (hole, i] */
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            roll_index[hole] = roll_index[i];
+            hole = i;
+        }
+    }
+    roll_index[hole].node = NULL;
+    roll_index[hole].prev = NULL;
+    --roll_index_count;
+}
+
+static void roll_index_clear(void) {
+    free(roll_index);
+    roll_index = NULL;
+    roll_index_cap = 0;
+    roll_index_count = 0;
+}
+
+/* --- running class statistics --- */
+
+typedef struct {
+    double sum;
+    double sumsq;
+    double min;
+    double max;
+    size_t min_count; /* students holding exactly min / max */
+    size_t max_count;
+    bool stale;       /* last holder of an extreme removed: rescan on next read */
+    size_t hist[DB_STAT_BINS];
+} StatAccum;
+
+static StatAccum stat_acc[DB_FIELD_COUNT];
+static size_t stat_n = 0;
+static bool stats_bulk = false; /* snapshot load: field totals are rebuilt afterwards */
+static DbBandFn band_fn = NULL;
+static int band_n = 0;
+static size_t band_counts[DB_MAX_BANDS];
+
+static double stat_value(int field, const Student *s) {
+    if (field < NUM_SUBJECTS) return s->marks[field];
+    if (field == DB_FIELD_ATTENDANCE) return s->attendance;
+    return student_average(s);
+}
+
+/* same binning as col_histogram(column, 0, 100, DB_STAT_BINS, ...) */
+static int stat_bin(double v) {
+    double f = v * ((double)DB_STAT_BINS / 100.0);
+    return f <= 0.0 ? 0 : (f >= (double)(DB_STAT_BINS - 1) ? DB_STAT_BINS - 1 : (int)f);
+}
+
+static int band_of(const Student *s) {
+    int b = band_fn(s);
+    return b < 0 ? 0 : (b >= band_n ? band_n - 1 : b);
+}
+
+static void stats_add(const Student *s) {
+    ++stat_n;
+    for (int f = 0; !stats_bulk && f < DB_FIELD_COUNT; ++f) {
+        StatAccum *a = &stat_acc[f];
+        double v = stat_value(f, s);
+        a->sum += v;
+        a->sumsq += v * v;
+        ++a->hist[stat_bin(v)];
+        if (a->stale) continue;
+        if (stat_n == 1 || v < a->min) { a->min = v; a->min_count = 1; }
+        else if (v == a->min) ++a->min_count;
+        if (stat_n == 1 || v > a->max) { a->max = v; a->max_count = 1; }
+        else if (v == a->max) ++a->max_count;
+    }
+    if (band_fn) ++band_counts[band_of(s)];
+}
+
+static void stats_remove(const Student *s) {
+    if (band_fn) --band_counts[band_of(s)];
+    if (--stat_n == 0) {
+        /* start again from exact zeros rather than accumulated rounding */
+        memset(stat_acc, 0, sizeof(stat_acc));
+        return;
+    }
+    for (int f = 0; f < DB_FIELD_COUNT; ++f) {
+        StatAccum *a = &stat_acc[f];
+        double v = stat_value(f, s);
+        a->sum -= v;
+        a->sumsq -= v * v;
+        --a->hist[stat_bin(v)];
+        if (a->stale) continue;
+        if (v == a->min && --a->min_count == 0) a->stale = true;
+        if (v == a->max && --a->max_count == 0) a->stale = true;
+    }
+}
+
+/* Recompute min/max (and holder counts) of a field from the columnar store; with
+   totals also its sum, sum of squares and histogram. Subject and attendance
+   columns go through the SIMD kernels (col_summary, col_histogram). */
+static void stats_rebuild(int field, bool totals) {
+    StatAccum *a = &stat_acc[field];
+    size_t rows = col_count();
+    if (totals) {
+        a->sum = a->sumsq = 0.0;
+        memset(a->hist, 0, sizeof(a->hist));
+    }
+    a->min = a->max = 0.0;
+    a->min_count = a->max_count = 0;
+    if (field != DB_FIELD_AVERAGE) {
+        const double *x = col_data(field);
+        ColumnSummary cs;
+        col_summary(field, &cs);
+        a->min = cs.min;
+        a->max = cs.max;
+        for (size_t row = 0; row < rows; ++row) {
+            a->min_count += x[row] == cs.min;
+            a->max_count += x[row] == cs.max;
+        }
+        if (totals) {
+            a->sum = cs.sum;
+            a->sumsq = cs.sumsq;
+            if (rows > 0 && !col_histogram(field, 0.0, 100.0, DB_STAT_BINS, a->hist))
+                for (size_t row = 0; row < rows; ++row) ++a->hist[stat_bin(x[row])];
+        }
+    } else {
+        for (size_t row = 0; row < rows; ++row) {
+            double v = 0.0;
+            for (int i = 0; i < NUM_SUBJECTS; ++i) v += col_data(i)[row];
+            v /= NUM_SUBJECTS;
+            if (totals) {
+                a->sum += v;
+                a->sumsq += v * v;
+                ++a->hist[stat_bin(v)];
+            }
+            if (row == 0 || v < a->min) { a->min = v; a->min_count = 1; }
+            else if (v == a->min) ++a->min_count;
+            if (row == 0 || v > a->max) { a->max = v; a->max_count = 1; }
+            else if (v == a->max) ++a->max_count;
+        }
+    }
+    a->stale = false;
+    METRIC_ADD(MET_RECORDS_SCANNED, rows);
+}
+
+/* Mirror a record's column row into the working snapshot version */
+static void snap_put(size_t row, const Record *r) {
+    if (!snap_on) return;
+    Student s;
+    record_load(r, &s);
+    mvcc_set(row, &s);
+}
+
+static void snap_count(void) {
+    if (snap_on) mvcc_set_count(roll_index_count);
+}
+
+/* Link node (holding s) at list head, index it (roll hash, roll order, name) and
+   give it a column row */
+static bool link_head(Record *node, const Student *s) {
+    size_t row = col_append(s->roll, s->marks, s->attendance);
+    if (row == (size_t)-1) return false;
+    int unused;
+    if (!name_index_add(s->name, s->roll)) {
+        col_remove(row, &unused);
+        return false;
+    }
+    if (!roll_order_insert(s->roll, node)) {
+        name_index_remove(s->name, s->roll);
+        col_remove(row, &unused);
+        return false;
+    }
+    if (!roll_index_insert(node, NULL, row)) {
+        roll_order_remove(s->roll);
+        name_index_remove(s->name, s->roll);
+        col_remove(row, &unused);
+        return false;
+    }
+    if (db_head) roll_index_find(db_head->roll)->prev = node;
+    node->next = db_head;
+    db_head = node;
+    stats_add(s);
+    snap_put(row, node);
+    snap_count();
+    return true;
+}
+
+/* New record for s, linked in; false (nothing changed) when out of memory */
+static bool add_record(const Student *s) {
+    Record *node = record_create(s);
+    if (!node) return false;
+    if (!link_head(node, s)) {
+        record_free(node);
+        return false;
+    }
+    return true;
 }
 
 /* Internal helper to find duplicate roll */
 static bool roll_exists(int roll) {
-    Student *cur = db_head;
-    while (cur) {
-        if (cur->roll == roll) return true;
-        cur = cur->next;
+    return roll_index_find(roll) != NULL;
+}
+
+/* Overwrite slot's record with s, keeping stats and the name index in step */
+static bool replace_record(RollSlot *slot, const Student *s) {
+    Student old;
+    record_load(slot->node, &old);
+    /* index the new name before dropping the old one, so a failure changes nothing */
+    bool renamed = strcmp(old.name, s->name) != 0;
+    if (renamed && !name_index_add(s->name, old.roll)) return false;
+    if (!record_store(slot->node, s)) {
+        if (renamed) name_index_remove(s->name, old.roll);
+        return false;
     }
-    return false;
+    if (renamed) name_index_remove(old.name, old.roll);
+    stats_remove(&old);
+    col_set(slot->row, s->marks, s->attendance);
+    stats_add(s);
+    snap_put(slot->row, slot->node);
+    return true;
 }
 
-/* Load database from binary file */
-bool db_load(const char *filename) {
-    FILE *f = fopen(filename, "rb");
-    if (!f) {
-        /* No file yet, that's fine - start with empty DB */
-        db_head = NULL;
-        return true;
+/* Unlink node from the list and indexes (does not free) */
+static Record *unlink_roll(int roll) {
+    RollSlot *slot = roll_index_find(roll);
+    if (!slot) return NULL;
+    Record *cur = slot->node;
+    Record *prev = slot->prev;
+    Record *nxt = cur->next;
+    if (prev) prev->next = nxt;
+    else db_head = nxt;
+    size_t row = slot->row;
+    roll_index_remove(slot);
+    if (nxt) roll_index_find(nxt->roll)->prev = prev;
+    int moved;
+    if (col_remove(row, &moved)) {
+        RollSlot *m = roll_index_find(moved);
+        m->row = row;
+        snap_put(row, m->node);
+    }
+    snap_count();
+    Student old;
+    record_load(cur, &old);
+    name_index_remove(old.name, roll);
+    roll_order_remove(roll);
+    stats_remove(&old);
+    return cur;
+}
+
+/* Insert or overwrite a record (used by load and journal replay; never journaled) */
+static bool upsert_record(const Student *rec) {
+    RollSlot *dup = roll_index_find(rec->roll);
+    /* later record for the same roll wins, as it did when it shadowed the older one */
+    if (dup) return replace_record(dup, rec);
+    return add_record(rec);
+}
+
+static bool replay_failed = false;
+
+static void replay_put(const Student *s) {
+    if (!upsert_record(s)) replay_failed = true;
+}
+
+static void replay_delete(int roll) {
+    record_free(unlink_roll(roll));
+}
+
+/* Log a mutation; failures are reported by the next db_commit */
+static void journal_record_put(const Student *s) {
+    if (db_bulk) return;
+    if (journal_is_open() && !journal_log_put(s)) db_journal_failed = true;
+}
+
+static void journal_record_delete(int roll) {
+    if (db_bulk) return;
+    if (journal_is_open() && !journal_log_delete(roll)) db_journal_failed = true;
+}
+
+/* --- background checkpoint ---
+   The interactive thread owns every in-memory structure. To checkpoint it copies
+   the records, moves the journal aside (journal_rotate) and queues the copy; the
+   checkpoint thread writes it like db_save and then deletes the moved journal.
+   Until then a restart replays snapshot, moved journal and new journal in order. */
+
+static pthread_mutex_t ckpt_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ckpt_cond = PTHREAD_COND_INITIALIZER; /* work queued, stop, or a write finished */
+static pthread_t ckpt_tid;
+static bool ckpt_running = false;
+static bool ckpt_stop = false;
+static DbDurability ckpt_mode = DB_DURABLE_IMMEDIATE;
+static int ckpt_interval_ms = 0;
+static Student *ckpt_records = NULL; /* queued copy, NULL when nothing is queued */
+static size_t ckpt_count = 0;
+static char ckpt_path[sizeof(db_path)];
+static bool ckpt_busy = false;     /* a copy is queued or being written */
+static bool ckpt_failed = false;   /* a background write failed; db_commit repairs with db_save */
+static bool ckpt_unsynced = false; /* journal appended since the last interval fsync */
+
+static bool file_exists(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (f) fclose(f);
+    return f != NULL;
+}
+
+static bool write_checkpoint(const char *path, const Student *recs, size_t n) {
+    METRIC_TIMER_START(t0);
+    StorageWriter w;
+    bool ok = storage_writer_open(&w, path, n);
+    if (ok) {
+        for (size_t i = 0; i < n; ++i) storage_writer_put(&w, &recs[i]);
+        ok = storage_writer_close(&w);
+    }
+    if (ok) {
+        /* the snapshot now holds every entry of the moved journal */
+        char opath[sizeof(ckpt_path) + 16];
+        journal_rotated_path_for(path, opath, sizeof(opath));
+        remove(opath);
+    }
+    METRIC_TIMER_STOP(MET_DB_CHECKPOINT, t0);
+    return ok;
+}
+
+static void *checkpoint_main(void *arg) {
+    (void)arg;
+    pthread_mutex_lock(&ckpt_lock);
+    for (;;) {
+        if (ckpt_records) {
+            Student *recs = ckpt_records;
+            size_t n = ckpt_count;
+            char path[sizeof(ckpt_path)];
+            memcpy(path, ckpt_path, sizeof(path));
+            ckpt_records = NULL;
+            pthread_mutex_unlock(&ckpt_lock);
+            bool ok = write_checkpoint(path, recs, n);
+            free(recs);
+            pthread_mutex_lock(&ckpt_lock);
+            if (!ok) ckpt_failed = true;
+            ckpt_busy = false;
+            pthread_cond_broadcast(&ckpt_cond);
+            continue;
+        }
+        if (ckpt_unsynced) {
+            /* group commit: one fsync covers every append since the last tick */
+            ckpt_unsynced = false;
+            pthread_mutex_unlock(&ckpt_lock);
+            bool ok = journal_sync();
+            pthread_mutex_lock(&ckpt_lock);
+            if (!ok) ckpt_failed = true;
+        }
+        if (ckpt_stop) break;
+        if (ckpt_mode == DB_DURABLE_INTERVAL) {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            long long ns = until.tv_nsec + (long long)ckpt_interval_ms * 1000000LL;
+            until.tv_sec += (time_t)(ns / 1000000000LL);
+            until.tv_nsec = (long)(ns % 1000000000LL);
+            pthread_cond_timedwait(&ckpt_cond, &ckpt_lock, &until);
+        } else {
+            pthread_cond_wait(&ckpt_cond, &ckpt_lock);
+        }
+    }
+    pthread_mutex_unlock(&ckpt_lock);
+    return NULL;
+}
+
+/* Copy the records and hand them to the thread (ckpt_lock held, nothing in flight) */
+static bool checkpoint_queue(void) {
+    Student *recs = (Student *)malloc(sizeof(Student) * (roll_index_count ? roll_index_count : 1));
+    if (!recs) return false;
+    size_t n = 0;
+    /* roll order: the snapshot delta-encodes rolls */
+    for (const OrderNode *o = roll_order_first(); o; o = roll_order_next(o))
+        record_load((const Record *)roll_order_value(o), &recs[n++]);
+    char opath[sizeof(db_path) + 16];
+    journal_rotated_path_for(db_path, opath, sizeof(opath));
+    if (!journal_rotate(opath)) {
+        free(recs);
+        return false;
     }
+    ckpt_records = recs;
+    ckpt_count = n;
+    memcpy(ckpt_path, db_path, sizeof(ckpt_path));
+    ckpt_busy = true;
+    db_snapshot_bytes = (long)(sizeof(StorageHeader) + n * db_record_bytes);
+    pthread_cond_broadcast(&ckpt_cond);
+    return true;
+}
 
+/* Block until no checkpoint is queued or being written */
+static void checkpoint_wait_idle(void) {
+    if (!ckpt_running) return;
+    pthread_mutex_lock(&ckpt_lock);
+    while (ckpt_busy) pthread_cond_wait(&ckpt_cond, &ckpt_lock);
+    pthread_mutex_unlock(&ckpt_lock);
+}
+
+/* One decoded chunk of the snapshot, visited last to first: prepending then leaves
+   the list in file order, and the last record for a duplicated roll is kept. */
+static bool load_chunk(const Student *recs, size_t n, void *ctx) {
+    (void)ctx;
+    for (size_t i = n; i-- > 0;) {
+        if (roll_exists(recs[i].roll)) continue;
+        if (!add_record(&recs[i])) return false;
+    }
+    return true;
+}
+
+/* Load database: last snapshot, then the journal replayed on top */
+static bool load_database(const char *filename) {
     /* Clear current in-memory list first */
     db_free_all();
+    snprintf(db_path, sizeof(db_path), "%s", filename);
+    db_snapshot_bytes = 0;
 
-    while (1) {
-        Student temp;
-        size_t read = fread(&temp, sizeof(Student), 1, f);
-        if (read != 1) break;
-        /* allocate new node and copy */
-        Student *node = (Student *)malloc(sizeof(Student));
-        if (!node) {
-            fclose(f);
-            return false;
-        }
-        memcpy(node, &temp, sizeof(Student));
-        node->next = db_head;
-        db_head = node;
+    StorageView v;
+    if (!storage_map(filename, &v)) return false;
+    /* Size the index up front instead of rehashing as it fills (only a hint:
+       duplicates make it larger than needed, and failing here is harmless). */
+    if (v.count < SIZE_MAX / 4) roll_index_reserve((size_t)v.count);
+    /* Blocks are decoded on worker threads while this one links the previous round in.
+       Field statistics are then built once from the columns rather than per record. */
+    stats_bulk = true;
+    bool scanned = storage_scan(&v, true, load_chunk, NULL);
+    stats_bulk = false;
+    for (int f = 0; f < DB_FIELD_COUNT; ++f) stats_rebuild(f, true);
+    if (!scanned) {
+        storage_unmap(&v);
+        return false;
+    }
+    db_snapshot_bytes = (long)v.map_len;
+    bool migrate = v.outdated;
+    storage_unmap(&v);
+
+    char jpath[sizeof(db_path) + 16], opath[sizeof(db_path) + 16];
+    journal_path_for(db_path, jpath, sizeof(jpath));
+    journal_rotated_path_for(db_path, opath, sizeof(opath));
+    bool torn = false, old_torn = false;
+    replay_failed = false;
+    /* a journal moved aside for a checkpoint that never finished comes first */
+    bool unfinished = file_exists(opath);
+    if (unfinished && !journal_replay(opath, replay_put, replay_delete, &old_torn)) return false;
+    if (!journal_replay(jpath, replay_put, replay_delete, &torn) || replay_failed) return false;
+    if (!journal_open(jpath)) return false;
+    db_journal_failed = false;
+    /* a torn tail would hide later appends from replay, so fold it away now;
+       an old-format snapshot or an unfinished checkpoint is completed the same way */
+    if (torn || migrate || unfinished) return db_save(db_path);
+    return true;
+}
+
+bool db_load(const char *filename) {
+    METRIC_TIMER_START(t0);
+    bool ok = load_database(filename);
+    if (snap_on) mvcc_publish();
+    METRIC_TIMER_STOP(MET_DB_LOAD, t0);
+    return ok;
+}
+
+/* Save DB into binary file (versioned format, see storage.h) */
+static bool save_snapshot(const char *filename) {
+    bool own_file = db_path[0] && strcmp(filename, db_path) == 0;
+    if (own_file) checkpoint_wait_idle();
+    StorageWriter w;
+    if (!storage_writer_open(&w, filename, roll_index_count)) return false;
+    for (const OrderNode *n = roll_order_first(); n; n = roll_order_next(n)) {
+        Student s;
+        record_load((const Record *)roll_order_value(n), &s);
+        storage_writer_put(&w, &s);
+    }
+    if (!storage_writer_close(&w)) return false;
+    long bytes = (long)w.bytes;
+    if (roll_index_count > 0)
+        db_record_bytes = (long)((w.bytes - sizeof(StorageHeader)) / roll_index_count) + 1;
+    /* the new snapshot contains every journaled change */
+    if (own_file) {
+        char opath[sizeof(db_path) + 16];
+        journal_rotated_path_for(db_path, opath, sizeof(opath));
+        remove(opath);
+        pthread_mutex_lock(&ckpt_lock);
+        ckpt_failed = false;
+        pthread_mutex_unlock(&ckpt_lock);
+    }
+    if (own_file && journal_is_open()) {
+        db_snapshot_bytes = bytes;
+        if (!journal_truncate()) return false;
+        db_journal_failed = false;
     }
-    fclose(f);
     return true;
 }
 
-/* Save DB into binary file */
 bool db_save(const char *filename) {
-    FILE *f = fopen(filename, "wb");
-    if (!f) return false;
-    Student *cur = db_head;
-    while (cur) {
-        if (fwrite(cur, sizeof(Student), 1, f) != 1) {
-            fclose(f);
-            return false;
-        }
-        cur = cur->next;
+    METRIC_TIMER_START(t0);
+    bool ok = save_snapshot(filename);
+    METRIC_TIMER_STOP(MET_DB_SAVE, t0);
+    return ok;
+}
+
+/* Make journaled mutations durable, compacting when the journal has grown large */
+bool db_commit(void) {
+    if (snap_on) mvcc_publish();
+    if (!db_path[0]) return false;
+    METRIC_TIMER_START(t0);
+    long limit = db_snapshot_bytes > JOURNAL_MIN_COMPACT_BYTES ? db_snapshot_bytes : JOURNAL_MIN_COMPACT_BYTES;
+    /* a failed append leaves the journal incomplete; a full snapshot repairs it */
+    bool repair = db_journal_failed || !journal_is_open();
+    bool ok = true;
+    if (!ckpt_running) {
+        if (repair || journal_size() > limit) ok = db_save(db_path);
+    } else {
+        pthread_mutex_lock(&ckpt_lock);
+        repair = repair || ckpt_failed;
+        /* while a checkpoint is in flight the journal keeps growing, and the
+           next commit after it finishes folds the whole burst into one write */
+        if (!repair && !ckpt_busy && journal_size() > limit) repair = !checkpoint_queue();
+        if (!repair && ckpt_mode == DB_DURABLE_INTERVAL) ckpt_unsynced = true;
+        pthread_mutex_unlock(&ckpt_lock);
+        if (repair) ok = db_save(db_path);
+        else if (ckpt_mode == DB_DURABLE_IMMEDIATE) ok = journal_sync();
     }
-    fclose(f);
+    METRIC_TIMER_STOP(MET_DB_COMMIT, t0);
+    return ok;
+}
+
+bool db_checkpoint_start(DbDurability mode, int interval_ms) {
+    if (mode == DB_DURABLE_INTERVAL && interval_ms <= 0) return false;
+    if (ckpt_running && !db_checkpoint_stop()) return false;
+    ckpt_mode = mode;
+    ckpt_interval_ms = interval_ms;
+    ckpt_stop = false;
+    ckpt_unsynced = false;
+    if (pthread_create(&ckpt_tid, NULL, checkpoint_main, NULL) != 0) return false;
+    ckpt_running = true;
     return true;
 }
 
-/* Add student if roll not present */
+bool db_checkpoint_stop(void) {
+    if (!ckpt_running) return true;
+    pthread_mutex_lock(&ckpt_lock);
+    ckpt_stop = true;
+    pthread_cond_broadcast(&ckpt_cond);
+    pthread_mutex_unlock(&ckpt_lock);
+    /* the thread writes a queued copy before it exits */
+    pthread_join(ckpt_tid, NULL);
+    ckpt_running = false;
+    bool ok = !ckpt_failed;
+    if (journal_is_open() && !journal_sync()) ok = false;
+    return ok;
+}
+
+void db_bulk_begin(void) {
+    db_bulk = true;
+}
+
+bool db_bulk_end(void) {
+    db_bulk = false;
+    if (snap_on) mvcc_publish();
+    if (!db_path[0]) return false;
+    return db_save(db_path);
+}
+
+/* Add student if roll not present; the database keeps its own compact copy */
 bool db_add_student(Student *s) {
     if (!s) return false;
-    if (roll_exists(s->roll)) return false;
-    s->next = db_head;
-    db_head = s;
-    return true;
+    METRIC_TIMER_START(t0);
+    bool ok = !roll_exists(s->roll) && add_record(s);
+    if (ok) {
+        journal_record_put(s);
+        free_student(s);
+    }
+    METRIC_TIMER_STOP(MET_DB_ADD, t0);
+    return ok;
 }
 
 /* Delete by roll */
 bool db_delete_by_roll(int roll) {
-    Student *cur = db_head;
-    Student *prev = NULL;
-    while (cur) {
-        if (cur->roll == roll) {
-            if (prev) prev->next = cur->next;
-            else db_head = cur->next;
-            free(cur);
-            return true;
-        }
-        prev = cur;
-        cur = cur->next;
+    METRIC_TIMER_START(t0);
+    Record *cur = unlink_roll(roll);
+    if (cur) {
+        record_free(cur);
+        journal_record_delete(roll);
     }
-    return false;
+    METRIC_TIMER_STOP(MET_DB_DELETE, t0);
+    if (!cur) return false;
+    if (db_change_hook) db_change_hook(roll);
+    return true;
 }
 
 /* Update student matched by roll */
 bool db_update_student(int roll, const char *new_name, double new_marks[], double new_attendance) {
-    Student *s = db_search_by_roll(roll);
-    if (!s) return false;
-    if (new_name) {
-        strncpy(s->name, new_name, NAME_LEN-1);
-        s->name[NAME_LEN-1] = '\0';
+    METRIC_TIMER_START(t0);
+    RollSlot *slot = roll_index_find(roll);
+    if (!slot) {
+        METRIC_TIMER_STOP(MET_DB_UPDATE, t0);
+        return false;
     }
+    Student s;
+    record_load(slot->node, &s);
+    if (new_name) snprintf(s.name, sizeof(s.name), "%s", new_name);
     if (new_marks) {
-        for (int i = 0; i < NUM_SUBJECTS; ++i) s->marks[i] = new_marks[i];
+        for (int i = 0; i < NUM_SUBJECTS; ++i) s.marks[i] = new_marks[i];
     }
-    s->attendance = new_attendance;
-    return true;
+    s.attendance = new_attendance;
+    bool ok = replace_record(slot, &s);
+    if (ok) journal_record_put(&s);
+    METRIC_TIMER_STOP(MET_DB_UPDATE, t0);
+    if (ok && db_change_hook) db_change_hook(roll);
+    return ok;
 }
 
+/* Copy handed out by the searches, one per thread (readers may search concurrently) */
+static _Thread_local Student search_result;
+
 /* Search by roll */
-Student *db_search_by_roll(int roll) {
-    Student *cur = db_head;
-    while (cur) {
-        if (cur->roll == roll) return cur;
-        cur = cur->next;
-    }
-    return NULL;
+const Student *db_search_by_roll(int roll) {
+    METRIC_SAMPLED_START(t0);
+    RollSlot *slot = roll_index_find(roll);
+    if (slot) record_load(slot->node, &search_result);
+    METRIC_SAMPLED_STOP(MET_DB_SEARCH_ROLL, t0);
+    return slot ? &search_result : NULL;
+}
+
+typedef struct {
+    const char *query;
+    NameMatch mode;
+    Student *out;
+    int max;
+    int found;
+    bool first_only; /* stop at the first match (db_search_by_name), loaded into search_result */
+} NameSearch;
+
+static bool collect_name_match(int roll, void *ctx) {
+    NameSearch *ns = (NameSearch *)ctx;
+    RollSlot *slot = roll_index_find(roll);
+    if (!slot) return true;
+    /* the index is case-insensitive; exact mode re-checks the original spelling */
+    if (ns->mode == NAME_MATCH_EXACT && strcmp(record_name(slot->node), ns->query) != 0) return true;
+    if (ns->first_only) record_load(slot->node, &search_result);
+    if (ns->out && ns->found < ns->max) record_load(slot->node, &ns->out[ns->found]);
+    ++ns->found;
+    return !ns->first_only;
 }
 
 /* Search by name (case-sensitive first match) */
-Student *db_search_by_name(const char *name) {
-    Student *cur = db_head;
-    while (cur) {
-        if (strcmp(cur->name, name) == 0) return cur;
-        cur = cur->next;
+const Student *db_search_by_name(const char *name) {
+    METRIC_TIMER_START(t0);
+    NameSearch ns = { name, NAME_MATCH_EXACT, NULL, 0, 0, true };
+    name_index_lookup(name, false, collect_name_match, &ns);
+    METRIC_TIMER_STOP(MET_DB_SEARCH_NAME, t0);
+    return ns.found ? &search_result : NULL;
+}
+
+int db_find_by_name(const char *query, NameMatch mode, Student *out, int max) {
+    if (!query) return 0;
+    METRIC_TIMER_START(t0);
+    NameSearch ns = { query, mode, out, max, 0, false };
+    name_index_lookup(query, mode == NAME_MATCH_PREFIX, collect_name_match, &ns);
+    METRIC_TIMER_STOP(MET_DB_FIND_NAME, t0);
+    return ns.found;
+}
+
+size_t db_count(void) {
+    return roll_index_count;
+}
+
+void db_foreach(void (*fn)(const Student *s, void *ctx), void *ctx) {
+    METRIC_TIMER_START(t0);
+    Student s;
+    for (const Record *cur = db_head; cur; cur = cur->next) {
+        record_load(cur, &s);
+        fn(&s, ctx);
+    }
+    METRIC_TIMER_STOP(MET_DB_FOREACH, t0);
+    METRIC_ADD(MET_RECORDS_SCANNED, roll_index_count);
+}
+
+/* --- ranking over the columnar store --- */
+
+/* Value of row for a ranking key; the average adds subjects in marks[] order like student_average */
+static double rank_value(int key, size_t row) {
+    if (key != RANK_BY_AVERAGE) return col_data(key)[row];
+    double sum = 0.0;
+    for (int i = 0; i < NUM_SUBJECTS; ++i) sum += col_data(i)[row];
+    return sum / NUM_SUBJECTS;
+}
+
+typedef struct {
+    double value;
+    int roll;
+} RankEntry;
+
+/* true when a ranks strictly before b */
+static bool rank_before(const RankEntry *a, const RankEntry *b, bool highest) {
+    if (a->value != b->value) return highest ? a->value > b->value : a->value < b->value;
+    return a->roll < b->roll;
+}
+
+/* Heap whose top is the entry ranked last among those kept */
+static void rank_sift_down(RankEntry *h, int n, int i, bool highest) {
+    for (;;) {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if (l < n && rank_before(&h[m], &h[l], highest)) m = l;
+        if (r < n && rank_before(&h[m], &h[r], highest)) m = r;
+        if (m == i) return;
+        RankEntry t = h[i];
+        h[i] = h[m];
+        h[m] = t;
+        i = m;
+    }
+}
+
+static void rank_sift_up(RankEntry *h, int i, bool highest) {
+    while (i > 0) {
+        int p = (i - 1) / 2;
+        if (!rank_before(&h[p], &h[i], highest)) return;
+        RankEntry t = h[i];
+        h[i] = h[p];
+        h[p] = t;
+        i = p;
     }
-    return NULL;
 }
 
-/* Print all (sorted ascending by roll) */
+static int top_k_scan(int key, bool highest, int k, Student *out) {
+    size_t rows = col_count();
+    if ((size_t)k > rows) k = (int)rows;
+    if (k == 0) return 0;
+    RankEntry *heap = (RankEntry *)malloc(sizeof(RankEntry) * (size_t)k);
+    if (!heap) return 0;
+    const int *rolls = col_rolls();
+    int n = 0;
+    for (size_t row = 0; row < rows; ++row) {
+        RankEntry e = { rank_value(key, row), rolls[row] };
+        if (n < k) {
+            heap[n] = e;
+            rank_sift_up(heap, n++, highest);
+        } else if (rank_before(&e, &heap[0], highest)) {
+            heap[0] = e;
+            rank_sift_down(heap, n, 0, highest);
+        }
+    }
+    /* pop the worst kept entry into the last free slot until sorted best first */
+    for (int end = n - 1; end > 0; --end) {
+        RankEntry t = heap[0];
+        heap[0] = heap[end];
+        heap[end] = t;
+        rank_sift_down(heap, end, 0, highest);
+    }
+    for (int i = 0; i < n; ++i) record_load(roll_index_find(heap[i].roll)->node, &out[i]);
+    free(heap);
+    METRIC_ADD(MET_RECORDS_SCANNED, rows);
+    return n;
+}
+
+int db_top_k(int key, bool highest, int k, Student *out) {
+    if (!out || k <= 0 || key < 0 || key > RANK_BY_AVERAGE) return 0;
+    METRIC_TIMER_START(t0);
+    int n = top_k_scan(key, highest, k, out);
+    METRIC_TIMER_STOP(MET_DB_TOP_K, t0);
+    return n;
+}
+
+bool db_rank_of(int roll, int key, int *rank, size_t *total) {
+    if (key < 0 || key > RANK_BY_AVERAGE) return false;
+    RollSlot *slot = roll_index_find(roll);
+    if (!slot) return false;
+    METRIC_TIMER_START(t0);
+    double mine = rank_value(key, slot->row);
+    size_t rows = col_count(), above = 0;
+    for (size_t row = 0; row < rows; ++row)
+        if (rank_value(key, row) > mine) ++above;
+    METRIC_TIMER_STOP(MET_DB_RANK_OF, t0);
+    METRIC_ADD(MET_RECORDS_SCANNED, rows);
+    if (rank) *rank = (int)above + 1;
+    if (total) *total = rows;
+    return true;
+}
+
+/* Print the pinned version in roll order; false if it cannot be sorted */
+static bool print_snapshot(const DbSnapshot *snap) {
+    size_t n = db_snapshot_count(snap);
+    const Student **order = (const Student **)malloc(sizeof(Student *) * (n ? n : 1));
+    if (!order || !db_snapshot_by_roll(snap, order)) {
+        free(order);
+        return false;
+    }
+    if (n == 0) printf("No student records available.\n");
+    METRIC_TIMER_START(t0);
+    for (size_t i = 0; i < n; ++i) print_student(order[i]);
+    METRIC_TIMER_STOP(MET_DB_PRINT_ALL, t0);
+    METRIC_ADD(MET_RECORDS_SCANNED, n);
+    free(order);
+    return true;
+}
+
+/* Print all (ascending by roll): a linear walk of the ordered index */
 void db_print_all(void) {
-    Student *cur = db_head;
-    if (!cur) {
+    DbSnapshot snap;
+    if (snap_on && db_snapshot_open(&snap)) {
+        bool printed = print_snapshot(&snap);
+        db_snapshot_close(&snap);
+        if (printed) return;
+    }
+    const OrderNode *n = roll_order_first();
+    if (!n) {
         printf("No student records available.\n");
         return;
     }
+    METRIC_TIMER_START(t0);
+    Student s;
+    for (; n; n = roll_order_next(n)) {
+        record_load((const Record *)roll_order_value(n), &s);
+        print_student(&s);
+    }
+    METRIC_TIMER_STOP(MET_DB_PRINT_ALL, t0);
+    METRIC_ADD(MET_RECORDS_SCANNED, roll_index_count);
+}
 
-    /* Count nodes */
+static int list_range(int lo, int hi, DbCursor *cursor, Student *out, int max) {
+    const OrderNode *n;
+    if (cursor && cursor->started) {
+        if (cursor->last_roll >= hi) return 0;
+        n = roll_order_lower_bound(cursor->last_roll + 1);
+    } else {
+        n = roll_order_lower_bound(lo);
+    }
     int count = 0;
-    for (Student *t = cur; t; t = t->next) ++count;
+    for (; n && count < max && roll_order_key(n) <= hi; n = roll_order_next(n)) {
+        record_load((const Record *)roll_order_value(n), &out[count++]);
+    }
+    if (cursor && count > 0) {
+        cursor->started = true;
+        cursor->last_roll = out[count - 1].roll;
+    }
+    return count;
+}
 
-    /* Create array of pointers */
-    Student **arr = (Student **)malloc(sizeof(Student *) * count);
-    if (!arr) {
-        /* Fallback: print unsorted list if allocation fails */
-        for (Student *t = cur; t; t = t->next) print_student(t);
-        return;
+int db_list_range(int lo, int hi, DbCursor *cursor, Student *out, int max) {
+    if (!out || max <= 0 || lo > hi) return 0;
+    METRIC_TIMER_START(t0);
+    int count = list_range(lo, hi, cursor, out, max);
+    METRIC_TIMER_STOP(MET_DB_LIST_RANGE, t0);
+    METRIC_ADD(MET_RECORDS_SCANNED, count);
+    return count;
+}
+
+bool db_stats(int field, DbStats *out) {
+    if (field < 0 || field >= DB_FIELD_COUNT || !out) return false;
+    memset(out, 0, sizeof(*out));
+    if (stat_n == 0) return true;
+    METRIC_TIMER_START(t0);
+    StatAccum *a = &stat_acc[field];
+    if (a->stale) stats_rebuild(field, false);
+    out->count = stat_n;
+    out->mean = a->sum / (double)stat_n;
+    double var = a->sumsq / (double)stat_n - out->mean * out->mean;
+    out->stddev = var > 0.0 ? sqrt(var) : 0.0;
+    out->min = a->min;
+    out->max = a->max;
+    memcpy(out->hist, a->hist, sizeof(out->hist));
+    METRIC_TIMER_STOP(MET_DB_STATS, t0);
+    return true;
+}
+
+bool db_set_band_fn(DbBandFn fn, int bands) {
+    if (fn && (bands <= 0 || bands > DB_MAX_BANDS)) return false;
+    band_fn = fn;
+    band_n = fn ? bands : 0;
+    memset(band_counts, 0, sizeof(band_counts));
+    Student s;
+    for (const Record *cur = fn ? db_head : NULL; cur; cur = cur->next) {
+        record_load(cur, &s);
+        ++band_counts[band_of(&s)];
     }
+    return true;
+}
 
-    int i = 0;
-    for (Student *t = cur; t; t = t->next) arr[i++] = t;
+size_t db_band_count(int band) {
+    if (band < 0 || band >= band_n) return 0;
+    return band_counts[band];
+}
 
-    qsort(arr, (size_t)count, sizeof(Student *), cmp_ptr_roll_asc);
+/* --- snapshots (versions live in mvcc.c) --- */
 
-    /* Print sorted */
-    for (i = 0; i < count; ++i) print_student(arr[i]);
+bool db_snapshots_enable(bool on) {
+    if (on == snap_on) return true;
+    mvcc_reset();
+    snap_on = false;
+    if (!on) return true;
+    Student s;
+    for (const Record *cur = db_head; cur; cur = cur->next) {
+        record_load(cur, &s);
+        if (!mvcc_set(roll_index_find(cur->roll)->row, &s)) {
+            mvcc_reset();
+            return false;
+        }
+    }
+    mvcc_set_count(roll_index_count);
+    snap_on = true;
+    mvcc_publish();
+    return true;
+}
 
-    free(arr);
+bool db_snapshot_open(DbSnapshot *snap) {
+    snap->version = mvcc_pin(&snap->reader);
+    return snap->version != NULL;
 }
 
-/* Free all nodes */
-void db_free_all(void) {
-    Student *cur = db_head;
-    while (cur) {
-        Student *n = cur->next;
-        free(cur);
-        cur = n;
+void db_snapshot_close(DbSnapshot *snap) {
+    if (snap->version) mvcc_unpin(snap->reader);
+    snap->version = NULL;
+}
+
+size_t db_snapshot_count(const DbSnapshot *snap) {
+    return mvcc_count(snap->version);
+}
+
+const Student *db_snapshot_get(const DbSnapshot *snap, size_t i) {
+    return mvcc_get(snap->version, i);
+}
+
+/* Sort key: roll with the sign bit flipped, so unsigned order is numeric order */
+static unsigned roll_key(const Student *s) {
+    return (unsigned)s->roll ^ 0x80000000u;
+}
+
+bool db_snapshot_by_roll(const DbSnapshot *snap, const Student **out) {
+    size_t n = db_snapshot_count(snap);
+    const Student **tmp = (const Student **)malloc(sizeof(Student *) * (n ? n : 1));
+    size_t *lo = (size_t *)calloc(2 * 65536, sizeof(size_t));
+    if (!tmp || !lo) {
+        free(tmp);
+        free(lo);
+        return false;
+    }
+    size_t *hi = lo + 65536;
+    for (size_t i = 0; i < n; ++i) {
+        tmp[i] = db_snapshot_get(snap, i);
+        unsigned k = roll_key(tmp[i]);
+        ++lo[k & 0xffff];
+        ++hi[k >> 16];
+    }
+    /* two stable counting passes over 16-bit digits: low digit into out, high back */
+    size_t sum_lo = 0, sum_hi = 0;
+    for (size_t d = 0; d < 65536; ++d) {
+        size_t c = lo[d];
+        lo[d] = sum_lo;
+        sum_lo += c;
+        c = hi[d];
+        hi[d] = sum_hi;
+        sum_hi += c;
     }
+    for (size_t i = 0; i < n; ++i) out[lo[roll_key(tmp[i]) & 0xffff]++] = tmp[i];
+    for (size_t i = 0; i < n; ++i) tmp[hi[roll_key(out[i]) >> 16]++] = out[i];
+    memcpy(out, tmp, sizeof(Student *) * n);
+    free(tmp);
+    free(lo);
+    METRIC_ADD(MET_RECORDS_SCANNED, n);
+    return true;
+}
+
+void db_set_change_hook(DbChangeHook hook) {
+    db_change_hook = hook;
+}
+
+/* Free all nodes: the record and student pools drop their slabs wholesale */
+void db_free_all(void) {
+    checkpoint_wait_idle();
+    pthread_mutex_lock(&ckpt_lock);
+    ckpt_failed = false;
+    pthread_mutex_unlock(&ckpt_lock);
     db_head = NULL;
+    record_release_all();
+    student_release_all();
+    roll_index_clear();
+    name_index_clear();
+    roll_order_clear();
+    col_clear();
+    if (snap_on) mvcc_reset();
+    memset(stat_acc, 0, sizeof(stat_acc));
+    stat_n = 0;
+    memset(band_counts, 0, sizeof(band_counts));
+    journal_close();
+    db_bulk = false;
+    db_path[0] = '\0';
 }
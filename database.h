@@ -3,17 +3,54 @@
 
 #include "student.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 /* Head pointer for student linked list is managed inside database.c */
 
 /* Load database from file (returns true on success).
-   If file does not exist yet, function will create empty DB in memory. */
+   If file does not exist yet, function will create empty DB in memory.
+   Any journal ("<filename>.journal") is replayed on top and kept open, so later
+   add/update/delete calls append a small log entry instead of rewriting the file. */
 bool db_load(const char *filename);
 
-/* Save current database to file (binary). */
+/* Save current database to file (binary). The file is replaced atomically (temp file,
+   fsync, rename), so a crash mid-save keeps the previous snapshot. Saving to the
+   loaded file waits for a background checkpoint and also empties its journal. */
 bool db_save(const char *filename);
 
-/* Add student to DB. Returns true on success, false if roll duplicate or memory error. */
+/* Make mutations since the last commit durable. Usually just confirms the journal
+   appends; folds the journal into a new snapshot once it grows past the snapshot size.
+   Returns false on I/O error. */
+bool db_commit(void);
+
+/* Background checkpointing. Once started, db_commit never rewrites the snapshot on
+   the calling thread: when the journal outgrows the snapshot it copies the records,
+   moves the journal aside and queues the copy for the checkpoint thread, which writes
+   a temp file, fsyncs it and renames it over the snapshot. Commits arriving meanwhile
+   only append to the new journal and are folded into the next checkpoint. */
+typedef enum {
+    DB_DURABLE_IMMEDIATE, /* db_commit returns once the journal entry is fsynced */
+    DB_DURABLE_INTERVAL,  /* the thread fsyncs the journal every interval_ms (group commit) */
+    DB_DURABLE_ON_EXIT    /* appends reach the OS only; db_checkpoint_stop / db_save make them durable */
+} DbDurability;
+
+/* Start (or restart with a new mode) the checkpoint thread. Returns false if
+   interval_ms <= 0 in interval mode or the thread cannot be created. */
+bool db_checkpoint_start(DbDurability mode, int interval_ms);
+
+/* Finish a queued checkpoint, fsync the journal and stop the thread. Returns false
+   if a background write or fsync failed since the last successful save. */
+bool db_checkpoint_stop(void);
+
+/* Bulk mode for large imports: until db_bulk_end, mutations are not journaled.
+   db_bulk_end writes one snapshot of the loaded file, so the whole batch becomes
+   durable at once (or, if the process dies first, not at all). */
+void db_bulk_begin(void);
+bool db_bulk_end(void);
+
+/* Add student to DB. Returns true on success, false if roll duplicate or memory error.
+   On success the database keeps a compact copy and frees s (see record.h); on
+   failure s still belongs to the caller. */
 bool db_add_student(Student *s);
 
 /* Delete student by roll. Returns true if deleted. */
@@ -22,16 +59,133 @@ bool db_delete_by_roll(int roll);
 /* Update student by roll. Returns true on success. */
 bool db_update_student(int roll, const char *new_name, double new_marks[], double new_attendance);
 
-/* Search by roll, returns pointer to Student (do not free). NULL if not found. */
-Student *db_search_by_roll(int roll);
+/* Search by roll. Returns a copy of the record (do not free), valid until the next
+   db_search_by_roll / db_search_by_name on the same thread; NULL if not found. */
+const Student *db_search_by_roll(int roll);
+
+/* Search by name (case-sensitive, first match). Returns a copy as above, or NULL. */
+const Student *db_search_by_name(const char *name);
+
+typedef enum {
+    NAME_MATCH_EXACT = 0,        /* same spelling */
+    NAME_MATCH_CASE_INSENSITIVE, /* same name ignoring ASCII case */
+    NAME_MATCH_PREFIX            /* name starts with query, ignoring case */
+} NameMatch;
+
+/* Find all students matching query via the name index (cost depends on the query
+   length and the number of matches, not on DB size). Copies up to max matches into
+   out (out may be NULL to only count). Returns the total number of matches. */
+int db_find_by_name(const char *query, NameMatch mode, Student *out, int max);
+
+/* Number of students in DB. */
+size_t db_count(void);
+
+/* Call fn for a copy of every student in list order. The Student is valid only during
+   the callback (copy it to keep it); fn must not add or delete students. */
+void db_foreach(void (*fn)(const Student *s, void *ctx), void *ctx);
+
+/* Per-student fields for rankings and statistics: 0..NUM_SUBJECTS-1 are the
+   subjects (student.h marks[] order), then attendance and the average */
+#define DB_FIELD_ATTENDANCE NUM_SUBJECTS
+#define DB_FIELD_AVERAGE (NUM_SUBJECTS + 1)
+#define DB_FIELD_COUNT (NUM_SUBJECTS + 2)
+
+/* Ranking keys */
+#define RANK_BY_ATTENDANCE DB_FIELD_ATTENDANCE
+#define RANK_BY_AVERAGE DB_FIELD_AVERAGE
+
+/* Copy the k best (highest == true) or worst students by key into out, best
+   first; equal values are ordered by ascending roll. Averages are computed as
+   student_average does. Returns the number copied (min(k, db_count())), or 0 for
+   an unknown key. Costs O(n log k), not a full sort. */
+int db_top_k(int key, bool highest, int k, Student *out);
+
+/* 1-based rank of roll by key, highest value first; tied students share the
+   best rank (1 + number of students strictly above). Sets *total to the class
+   size when non-NULL. Returns false if roll is not found or key is unknown. */
+bool db_rank_of(int roll, int key, int *rank, size_t *total);
 
-/* Search by name (first match). Returns pointer or NULL. */
-Student *db_search_by_name(const char *name);
+/* Class statistics, maintained as students are added, updated and deleted */
+#define DB_STAT_BINS 10 /* histogram bins of width 10 over [0, 100]; 100 falls in the last */
 
-/* Print all students */
+typedef struct {
+    size_t count;
+    double mean;
+    double min;
+    double max;
+    double stddev; /* population */
+    size_t hist[DB_STAT_BINS];
+} DbStats;
+
+/* Statistics of one field (DB_FIELD_*). Constant time, except the first call after
+   the last student holding the minimum or maximum was removed, which rescans the
+   column once. Returns false for an unknown field. */
+bool db_stats(int field, DbStats *out);
+
+/* Optional per-student band (e.g. risk level) counted alongside the statistics.
+   fn must return 0..bands-1 and depend only on the record. Setting it, or
+   calling again after fn's answers change, recounts every student once. */
+#define DB_MAX_BANDS 8
+typedef int (*DbBandFn)(const Student *s);
+bool db_set_band_fn(DbBandFn fn, int bands);
+
+/* Number of students in a band; 0 without a band function. */
+size_t db_band_count(int band);
+
+/* Print all students in ascending roll order (walks the ordered roll index, no sorting).
+   With snapshots enabled it prints the last committed version instead. */
 void db_print_all(void);
 
-/* Free all in-memory student list (does not save). */
+/* Resume point for paged listings; start from DB_CURSOR_INIT */
+typedef struct {
+    int last_roll; /* last roll returned so far */
+    bool started;  /* false until the first page was returned */
+} DbCursor;
+
+#define DB_CURSOR_INIT { 0, false }
+
+/* Copy up to max students with lo <= roll <= hi into out, ascending by roll.
+   With a cursor, continues after the last roll it returned and advances it, so
+   repeated calls page through the range. Returns the number copied (0 at the end). */
+int db_list_range(int lo, int hi, DbCursor *cursor, Student *out, int max);
+
+/* Read-only snapshots. While enabled, db_commit (and load, enabling, db_bulk_end)
+   publishes the committed state as an immutable version. A reader on any thread can
+   pin it and walk every record without locks while add/update/delete go on and
+   publish newer versions. Versions share unchanged records (copy-on-write), and old
+   ones are freed once no pinned reader can see them. Enabling keeps a second copy of
+   every record in memory. */
+typedef struct {
+    const struct MvccVersion *version;
+    int reader;
+} DbSnapshot;
+
+/* Start or stop maintaining versions (off by default). Stopping frees them all, so no
+   snapshot may be open. Returns false if memory runs out. */
+bool db_snapshots_enable(bool on);
+
+/* Pin the latest committed version. Safe from any thread, also while another thread
+   mutates the database. Returns false when snapshots are off (or ran out of memory)
+   or too many snapshots are open. Close every snapshot that was opened. */
+bool db_snapshot_open(DbSnapshot *snap);
+void db_snapshot_close(DbSnapshot *snap);
+
+/* Number of students in the snapshot, and the i-th of them (unordered, i < count).
+   Records stay valid until the snapshot is closed; their next is NULL. */
+size_t db_snapshot_count(const DbSnapshot *snap);
+const Student *db_snapshot_get(const DbSnapshot *snap, size_t i);
+
+/* Fill out (db_snapshot_count entries) with the snapshot's records in ascending roll
+   order (radix sort, O(n)). Returns false if memory runs out. */
+bool db_snapshot_by_roll(const DbSnapshot *snap, const Student **out);
+
+/* Hook called with the roll of every record changed by db_update_student or
+   removed by db_delete_by_roll (e.g. to invalidate derived caches). NULL disables. */
+typedef void (*DbChangeHook)(int roll);
+void db_set_change_hook(DbChangeHook hook);
+
+/* Free all in-memory student list (does not save).
+   Releases the whole student pool, so students created but never added are freed too. */
 void db_free_all(void);
 
 #endif /* DATABASE_H */
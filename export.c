@@ -0,0 +1,333 @@
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "export.h"
+#include "student.h"
+#include "database.h"
+#include "metrics.h"
+
+#define EXPORT_CHUNK 4096        /* students per chunk */
+#define EXPORT_MAX_THREADS 16
+#define EXPORT_RECORD_RESERVE 4096 /* worst case per record, incl. escaped name and long numbers */
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+} OutBuf;
+
+static bool outbuf_reserve(OutBuf *b, size_t extra) {
+    if (b->len + extra <= b->cap) return true;
+    size_t ncap = b->cap ? b->cap : (size_t)EXPORT_CHUNK * 256;
+    while (ncap < b->len + extra) ncap *= 2;
+    char *d = (char *)realloc(b->data, ncap);
+    if (!d) return false;
+    b->data = d;
+    b->cap = ncap;
+    return true;
+}
+
+/* --- number formatting --- */
+
+static char *put_str(char *p, const char *s) {
+    while (*s) *p++ = *s++;
+    return p;
+}
+
+static char *put_uint(char *p, unsigned long v) {
+    char tmp[24];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    while (n) *p++ = tmp[--n];
+    return p;
+}
+
+static char *put_int(char *p, int v) {
+    if (v < 0) {
+        *p++ = '-';
+        return put_uint(p, (unsigned long)(-(long)v));
+    }
+    return put_uint(p, (unsigned long)v);
+}
+
+/* v * 100 as an integer when that is what "%.2f" rounds to; false near a rounding
+   tie or outside the fast range, where the caller falls back to snprintf */
+static bool fixed2_cents(double v, unsigned long *cents) {
+    if (!(v >= 0.0 && v <= 1e6) || signbit(v)) return false;
+    double x = v * 100.0;
+    double r = nearbyint(x);
+    if (0.5 - fabs(x - r) < 1e-6) return false;
+    *cents = (unsigned long)r;
+    return true;
+}
+
+static char *put_cents(char *p, unsigned long cents, bool trim) {
+    p = put_uint(p, cents / 100);
+    unsigned d = (unsigned)(cents % 100);
+    if (trim && d == 0) return p;
+    *p++ = '.';
+    *p++ = (char)('0' + d / 10);
+    if (!trim || d % 10) *p++ = (char)('0' + d % 10);
+    return p;
+}
+
+/* Exactly what printf("%.2lf") prints */
+static char *put_fixed2(char *p, double v) {
+    unsigned long cents;
+    if (fixed2_cents(v, &cents)) return put_cents(p, cents, false);
+    return p + sprintf(p, "%.2f", v);
+}
+
+/* Shortest of "72", "72.5", "72.25" when it reads back as v, else 17 significant digits */
+static char *put_exact(char *p, double v, bool json) {
+    unsigned long cents;
+    if (fixed2_cents(v, &cents) && (double)cents / 100.0 == v) return put_cents(p, cents, true);
+    if (json && !isfinite(v)) return put_str(p, "null");
+    return p + sprintf(p, "%.17g", v);
+}
+
+/* --- record renderers; each writes at most EXPORT_RECORD_RESERVE bytes --- */
+
+static char *render_csv(char *p, const Student *s) {
+    p = put_int(p, s->roll);
+    *p++ = ',';
+    const char *n = s->name;
+    size_t len = strlen(n);
+    bool quote = len && (isspace((unsigned char)n[0]) || isspace((unsigned char)n[len - 1]));
+    for (const char *c = n; *c && !quote; ++c) quote = *c == ',' || *c == '"' || *c == '\n' || *c == '\r';
+    if (quote) *p++ = '"';
+    for (const char *c = n; *c; ++c) {
+        if (*c == '"') *p++ = '"';
+        *p++ = *c;
+    }
+    if (quote) *p++ = '"';
+    for (int i = 0; i < NUM_SUBJECTS; ++i) {
+        *p++ = ',';
+        p = put_exact(p, s->marks[i], false);
+    }
+    *p++ = ',';
+    p = put_exact(p, s->attendance, false);
+    *p++ = '\n';
+    return p;
+}
+
+static char *render_jsonl(char *p, const Student *s) {
+    static const char hex[] = "0123456789abcdef";
+    p = put_str(p, "{\"roll\":");
+    p = put_int(p, s->roll);
+    p = put_str(p, ",\"name\":\"");
+    for (const unsigned char *c = (const unsigned char *)s->name; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            *p++ = '\\';
+            *p++ = (char)*c;
+        } else if (*c < 0x20) {
+            p = put_str(p, "\\u00");
+            *p++ = hex[*c >> 4];
+            *p++ = hex[*c & 15];
+        } else {
+            *p++ = (char)*c;
+        }
+    }
+    p = put_str(p, "\",\"marks\":[");
+    for (int i = 0; i < NUM_SUBJECTS; ++i) {
+        if (i) *p++ = ',';
+        p = put_exact(p, s->marks[i], true);
+    }
+    p = put_str(p, "],\"attendance\":");
+    p = put_exact(p, s->attendance, true);
+    p = put_str(p, "}\n");
+    return p;
+}
+
+static char *render_pretty(char *p, const Student *s) {
+    static const char *labels[NUM_SUBJECTS] = {
+        "Mathematics   : ", "Physics       : ", "Chemistry     : ", "ComputerScience: ", "English       : "
+    };
+    static const char rule[] = "--------------------------------------------------\n";
+    p = put_str(p, rule);
+    p = put_str(p, "Name       : ");
+    p = put_str(p, s->name);
+    p = put_str(p, "\nRoll No.   : ");
+    p = put_int(p, s->roll);
+    p = put_str(p, "\nAttendance : ");
+    p = put_fixed2(p, s->attendance);
+    p = put_str(p, "%\n");
+    for (int i = 0; i < NUM_SUBJECTS; ++i) {
+        p = put_str(p, labels[i]);
+        p = put_fixed2(p, s->marks[i]);
+        *p++ = '\n';
+    }
+    p = put_str(p, "Average    : ");
+    p = put_fixed2(p, student_average(s));
+    *p++ = '\n';
+    p = put_str(p, rule);
+    return p;
+}
+
+/* --- chunk pipeline --- */
+
+typedef struct {
+    Student *in;
+    int count;
+    ExportFormat fmt;
+    OutBuf out;
+    bool ok;
+} ExportChunk;
+
+static void *format_chunk(void *arg) {
+    ExportChunk *c = (ExportChunk *)arg;
+    c->out.len = 0;
+    c->ok = true;
+    for (int i = 0; i < c->count; ++i) {
+        if (!outbuf_reserve(&c->out, EXPORT_RECORD_RESERVE)) {
+            c->ok = false;
+            break;
+        }
+        char *start = c->out.data + c->out.len, *end;
+        switch (c->fmt) {
+            case EXPORT_CSV: end = render_csv(start, &c->in[i]); break;
+            case EXPORT_JSONL: end = render_jsonl(start, &c->in[i]); break;
+            default: end = render_pretty(start, &c->in[i]); break;
+        }
+        c->out.len += (size_t)(end - start);
+    }
+    return NULL;
+}
+
+bool export_format_from_name(const char *name, ExportFormat *fmt) {
+    if (strcmp(name, "csv") == 0) *fmt = EXPORT_CSV;
+    else if (strcmp(name, "jsonl") == 0) *fmt = EXPORT_JSONL;
+    else if (strcmp(name, "pretty") == 0) *fmt = EXPORT_PRETTY;
+    else return false;
+    return true;
+}
+
+static int online_cpus(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0) return n > EXPORT_MAX_THREADS ? EXPORT_MAX_THREADS : (int)n;
+#endif
+    return 1;
+}
+
+/* Where chunks come from: a pinned snapshot in roll order when snapshots are enabled
+   (writers on other threads are not held up), otherwise the live roll index. */
+typedef struct {
+    DbSnapshot snap;
+    const Student **order; /* NULL: read through db_list_range */
+    size_t count, pos;
+    DbCursor cursor;
+} ExportSource;
+
+static void source_open(ExportSource *src) {
+    memset(src, 0, sizeof(*src));
+    if (!db_snapshot_open(&src->snap)) return;
+    src->count = db_snapshot_count(&src->snap);
+    src->order = (const Student **)malloc(sizeof(Student *) * (src->count ? src->count : 1));
+    if (!src->order || !db_snapshot_by_roll(&src->snap, src->order)) {
+        free(src->order);
+        src->order = NULL;
+        db_snapshot_close(&src->snap);
+    }
+}
+
+static int source_next(ExportSource *src, Student *out) {
+    if (!src->order) return db_list_range(INT_MIN, INT_MAX, &src->cursor, out, EXPORT_CHUNK);
+    int n = 0;
+    for (; n < EXPORT_CHUNK && src->pos < src->count; ++n) out[n] = *src->order[src->pos++];
+    return n;
+}
+
+static void source_close(ExportSource *src) {
+    if (!src->order) return;
+    free(src->order);
+    db_snapshot_close(&src->snap);
+}
+
+static bool export_run(FILE *out, ExportFormat fmt, int threads, size_t *written, size_t *bytes) {
+    if (written) *written = 0;
+    if (!out) return false;
+    if (threads <= 0) threads = online_cpus();
+    if (threads > EXPORT_MAX_THREADS) threads = EXPORT_MAX_THREADS;
+    /* with one thread a single chunk is formatted and written at a time */
+    ExportChunk *chunks = (ExportChunk *)calloc((size_t)threads, sizeof(ExportChunk));
+    if (!chunks) return false;
+    bool ok = true;
+    for (int t = 0; t < threads && ok; ++t) {
+        chunks[t].fmt = fmt;
+        chunks[t].in = (Student *)malloc(sizeof(Student) * EXPORT_CHUNK);
+        if (!chunks[t].in) ok = false;
+    }
+    if (ok && fmt == EXPORT_CSV) {
+        static const char header[] = "roll,name,math,physics,chemistry,cs,english,attendance\n";
+        ok = fwrite(header, 1, sizeof(header) - 1, out) == sizeof(header) - 1;
+        if (ok) *bytes += sizeof(header) - 1;
+    }
+
+    ExportSource source;
+    source_open(&source);
+    size_t total = 0;
+    bool more = ok;
+    while (more) {
+        /* copy the next batch of chunks out of the database, in roll order */
+        int filled = 0;
+        while (filled < threads) {
+            ExportChunk *c = &chunks[filled];
+            c->count = source_next(&source, c->in);
+            if (c->count == 0) {
+                more = false;
+                break;
+            }
+            ++filled;
+            if (c->count < EXPORT_CHUNK) {
+                more = false;
+                break;
+            }
+        }
+        /* format them side by side, then write in order */
+        pthread_t tid[EXPORT_MAX_THREADS];
+        bool started[EXPORT_MAX_THREADS] = {false};
+        for (int t = 1; t < filled; ++t)
+            started[t] = pthread_create(&tid[t], NULL, format_chunk, &chunks[t]) == 0;
+        format_chunk(&chunks[0]);
+        for (int t = 1; t < filled; ++t) {
+            if (started[t]) pthread_join(tid[t], NULL);
+            else format_chunk(&chunks[t]);
+        }
+        for (int t = 0; t < filled; ++t) {
+            ExportChunk *c = &chunks[t];
+            if (!c->ok || fwrite(c->out.data, 1, c->out.len, out) != c->out.len) {
+                ok = more = false;
+                break;
+            }
+            total += (size_t)c->count;
+            *bytes += c->out.len;
+        }
+    }
+    source_close(&source);
+    if (fflush(out) != 0) ok = false;
+    for (int t = 0; t < threads; ++t) {
+        free(chunks[t].in);
+        free(chunks[t].out.data);
+    }
+    free(chunks);
+    if (written) *written = total;
+    return ok;
+}
+
+bool export_students(FILE *out, ExportFormat fmt, int threads, size_t *written) {
+    METRIC_TIMER_START(t0);
+    size_t records = 0, bytes = 0;
+    bool ok = export_run(out, fmt, threads, &records, &bytes);
+    METRIC_TIMER_STOP(MET_EXPORT, t0);
+    METRIC_ADD(MET_BYTES_WRITTEN, bytes);
+    if (written) *written = records;
+    return ok;
+}
@@ -0,0 +1,31 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Streaming export of the whole roster in ascending roll order.
+   Records are copied out of the database in chunks, rendered into large
+   per-chunk buffers (optionally by several threads at once) and written
+   to the stream in order with one fwrite per chunk. */
+
+typedef enum {
+    EXPORT_CSV,    /* same columns as the CSV import, with a header line */
+    EXPORT_JSONL,  /* same objects as the JSON Lines import */
+    EXPORT_PRETTY  /* the print_student layout */
+} ExportFormat;
+
+/* "csv", "jsonl" or "pretty"; returns false for anything else. */
+bool export_format_from_name(const char *name, ExportFormat *fmt);
+
+/* Write every student to out. threads > 1 formats that many chunks in parallel;
+   0 picks the number of online CPUs. CSV and JSON Lines print marks with at most
+   two decimals when that is exact, otherwise with full precision, so an export
+   imports back to the same values. Sets *written (if non-NULL) to the number of
+   records written. With snapshots enabled (db_snapshots_enable) the export is of the
+   last committed version and may run while other threads change the database.
+   Returns false on a write or allocation error. */
+bool export_students(FILE *out, ExportFormat fmt, int threads, size_t *written);
+
+#endif /* EXPORT_H */
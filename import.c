@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include "import.h"
+#include "student.h"
+#include "database.h"
+#include "metrics.h"
+
+#define IMPORT_LINE_MAX 4096
+#define IMPORT_READ_BUFFER (1 << 20)
+
+/* One parsed row; name is bounded by NAME_LEN like Student.name */
+typedef struct {
+    int roll;
+    char name[NAME_LEN];
+    double marks[NUM_SUBJECTS];
+    double attendance;
+} ImportRow;
+
+bool import_format_from_path(const char *path, ImportFormat *fmt) {
+    const char *dot = strrchr(path, '.');
+    if (!dot) return false;
+    char ext[8];
+    size_t n = 0;
+    for (const char *p = dot + 1; *p && n + 1 < sizeof(ext); ++p) ext[n++] = (char)tolower((unsigned char)*p);
+    ext[n] = '\0';
+    if (strcmp(ext, "csv") == 0) *fmt = IMPORT_CSV;
+    else if (strcmp(ext, "jsonl") == 0 || strcmp(ext, "ndjson") == 0 || strcmp(ext, "json") == 0) *fmt = IMPORT_JSONL;
+    else return false;
+    return true;
+}
+
+static bool parse_int_field(const char *s, const char *end, int *out) {
+    char buf[32];
+    while (s < end && isspace((unsigned char)*s)) ++s;
+    while (end > s && isspace((unsigned char)end[-1])) --end;
+    size_t len = (size_t)(end - s);
+    if (len == 0 || len >= sizeof(buf)) return false;
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+    char *stop;
+    errno = 0;
+    long v = strtol(buf, &stop, 10);
+    if (*stop || errno || v < INT_MIN || v > INT_MAX) return false;
+    *out = (int)v;
+    return true;
+}
+
+static bool parse_double_field(const char *s, const char *end, double *out) {
+    char buf[64];
+    while (s < end && isspace((unsigned char)*s)) ++s;
+    while (end > s && isspace((unsigned char)end[-1])) --end;
+    size_t len = (size_t)(end - s);
+    if (len == 0 || len >= sizeof(buf)) return false;
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+    char *stop;
+    *out = strtod(buf, &stop);
+    return *stop == '\0';
+}
+
+/* --- CSV --- */
+
+#define CSV_FIELDS (2 + NUM_SUBJECTS + 1)
+
+/* Split line in place into fields; quoted fields may contain commas and "" escapes.
+   Returns the number of fields, or -1 on a malformed quote. */
+static int csv_split(char *line, char *start[], char *end[], int max) {
+    int n = 0;
+    char *p = line;
+    for (;;) {
+        if (n == max) return max + 1;
+        while (*p == ' ' || *p == '\t') ++p;
+        if (*p == '"') {
+            char *w = ++p;
+            start[n] = w;
+            for (;;) {
+                if (!*p) return -1;
+                if (*p == '"') {
+                    if (p[1] != '"') break;
+                    ++p;
+                }
+                *w++ = *p++;
+            }
+            end[n] = w;
+            ++p;
+            while (*p == ' ' || *p == '\t') ++p;
+            if (*p && *p != ',') return -1;
+        } else {
+            start[n] = p;
+            while (*p && *p != ',') ++p;
+            end[n] = p;
+            /* unquoted fields lose surrounding blanks; quoted ones keep them */
+            while (end[n] > start[n] && (end[n][-1] == ' ' || end[n][-1] == '\t')) --end[n];
+        }
+        ++n;
+        if (!*p) return n;
+        ++p; /* comma */
+    }
+}
+
+static const char *csv_row(char *line, ImportRow *row) {
+    char *start[CSV_FIELDS], *end[CSV_FIELDS];
+    int n = csv_split(line, start, end, CSV_FIELDS);
+    if (n < 0) return "unterminated quoted field";
+    if (n != CSV_FIELDS) return "expected 8 fields: roll,name,5 marks,attendance";
+    if (!parse_int_field(start[0], end[0], &row->roll)) return "invalid roll";
+    char *s = start[1], *e = end[1];
+    if (s == e) return "empty name";
+    if ((size_t)(e - s) >= NAME_LEN) return "name too long";
+    memcpy(row->name, s, (size_t)(e - s));
+    row->name[e - s] = '\0';
+    for (int i = 0; i < NUM_SUBJECTS; ++i)
+        if (!parse_double_field(start[2 + i], end[2 + i], &row->marks[i])) return "invalid mark";
+    if (!parse_double_field(start[CSV_FIELDS - 1], end[CSV_FIELDS - 1], &row->attendance)) return "invalid attendance";
+    return NULL;
+}
+
+/* A first line whose roll column is not a number is taken as a header */
+static bool csv_is_header(const char *line) {
+    const char *p = line;
+    while (*p == ' ' || *p == '\t' || *p == '"') ++p;
+    return *p && !isdigit((unsigned char)*p) && *p != '-' && *p != '+';
+}
+
+/* --- JSON Lines: one flat object per line, parsed without allocation --- */
+
+static const char *json_ws(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r') ++p;
+    return p;
+}
+
+/* Parse a string into out (truncated to outlen-1 bytes, non-ASCII \u escapes as '?'). */
+static const char *json_string(const char *p, char *out, size_t outlen, bool *too_long) {
+    if (*p != '"') return NULL;
+    ++p;
+    size_t n = 0;
+    *too_long = false;
+    while (*p != '"') {
+        char c = *p++;
+        if (!c) return NULL;
+        if (c == '\\') {
+            char e = *p++;
+            switch (e) {
+                case '"': case '\\': case '/': c = e; break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u': {
+                    unsigned v = 0;
+                    for (int i = 0; i < 4; ++i, ++p) {
+                        if (!isxdigit((unsigned char)*p)) return NULL;
+                        v = v * 16 + (unsigned)(isdigit((unsigned char)*p) ? *p - '0' : tolower((unsigned char)*p) - 'a' + 10);
+                    }
+                    c = v < 0x80 ? (char)v : '?';
+                    break;
+                }
+                default: return NULL;
+            }
+        }
+        if (n + 1 < outlen) out[n++] = c;
+        else *too_long = true;
+    }
+    if (outlen) out[n] = '\0';
+    return p + 1;
+}
+
+static const char *json_number(const char *p, double *out) {
+    char *end;
+    *out = strtod(p, &end);
+    return end == p ? NULL : end;
+}
+
+/* Skip a scalar value of a key we do not use */
+static const char *json_skip_value(const char *p) {
+    if (*p == '"') {
+        char tmp[1];
+        bool long_str;
+        return json_string(p, tmp, 0, &long_str);
+    }
+    if (strncmp(p, "true", 4) == 0) return p + 4;
+    if (strncmp(p, "false", 5) == 0) return p + 5;
+    if (strncmp(p, "null", 4) == 0) return p + 4;
+    double d;
+    return json_number(p, &d);
+}
+
+static const char *jsonl_row(const char *line, ImportRow *row) {
+    enum { HAVE_ROLL = 1, HAVE_NAME = 2, HAVE_MARKS = 4, HAVE_ATT = 8 };
+    int have = 0;
+    const char *p = json_ws(line);
+    if (*p != '{') return "expected a JSON object";
+    p = json_ws(p + 1);
+    if (*p == '}') return "empty object";
+    for (;;) {
+        char key[32];
+        bool long_key;
+        p = json_string(p, key, sizeof(key), &long_key);
+        if (!p) return "malformed key";
+        p = json_ws(p);
+        if (*p != ':') return "expected ':'";
+        p = json_ws(p + 1);
+        if (!long_key && strcmp(key, "roll") == 0) {
+            double v;
+            p = json_number(p, &v);
+            if (!p || !(v >= INT_MIN && v <= INT_MAX) || v != (double)(int)v) return "invalid roll";
+            row->roll = (int)v;
+            have |= HAVE_ROLL;
+        } else if (!long_key && strcmp(key, "name") == 0) {
+            bool too_long;
+            p = json_string(p, row->name, sizeof(row->name), &too_long);
+            if (!p) return "invalid name";
+            if (too_long) return "name too long";
+            if (!row->name[0]) return "empty name";
+            have |= HAVE_NAME;
+        } else if (!long_key && strcmp(key, "marks") == 0) {
+            if (*p != '[') return "marks must be an array";
+            p = json_ws(p + 1);
+            for (int i = 0; i < NUM_SUBJECTS; ++i) {
+                if (i > 0) {
+                    if (*p != ',') return "marks must have 5 numbers";
+                    p = json_ws(p + 1);
+                }
+                p = json_number(p, &row->marks[i]);
+                if (!p) return "invalid mark";
+                p = json_ws(p);
+            }
+            if (*p != ']') return "marks must have 5 numbers";
+            ++p;
+            have |= HAVE_MARKS;
+        } else if (!long_key && strcmp(key, "attendance") == 0) {
+            p = json_number(p, &row->attendance);
+            if (!p) return "invalid attendance";
+            have |= HAVE_ATT;
+        } else {
+            p = json_skip_value(p);
+            if (!p) return "unsupported value (nested objects/arrays are only allowed for marks)";
+        }
+        p = json_ws(p);
+        if (*p == '}') break;
+        if (*p != ',') return "expected ',' or '}'";
+        p = json_ws(p + 1);
+    }
+    p = json_ws(p + 1);
+    if (*p && *p != '\n') return "trailing characters after object";
+    if (!(have & HAVE_ROLL)) return "missing roll";
+    if (!(have & HAVE_NAME)) return "missing name";
+    if (!(have & HAVE_MARKS)) return "missing marks";
+    if (!(have & HAVE_ATT)) return "missing attendance";
+    return NULL;
+}
+
+/* --- driver --- */
+
+static void report(ImportErrorFn on_error, void *ctx, ImportStats *st, size_t line, const char *msg) {
+    ++st->rejected;
+    if (on_error) on_error(line, msg, ctx);
+}
+
+static bool blank(const char *s) {
+    while (isspace((unsigned char)*s)) ++s;
+    return *s == '\0';
+}
+
+bool import_file(const char *path, ImportFormat fmt, bool update_existing,
+                 ImportErrorFn on_error, void *ctx, ImportStats *stats) {
+    ImportStats st = {0, 0, 0, 0};
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return false;
+    METRIC_TIMER_START(t0);
+    setvbuf(fp, NULL, _IOFBF, IMPORT_READ_BUFFER);
+    char line[IMPORT_LINE_MAX];
+    size_t lineno = 0;
+    bool ok = true;
+    while (fgets(line, sizeof(line), fp)) {
+        ++lineno;
+        size_t len = strlen(line);
+        if (len == sizeof(line) - 1 && line[len - 1] != '\n' && !feof(fp)) {
+            /* drain the rest of an over-long line */
+            int c;
+            while ((c = fgetc(fp)) != EOF && c != '\n') {}
+            ++st.lines;
+            report(on_error, ctx, &st, lineno, "line too long");
+            continue;
+        }
+        while (len && (line[len - 1] == '\n' || line[len - 1] == '\r')) line[--len] = '\0';
+        if (blank(line)) continue;
+        ++st.lines;
+        if (fmt == IMPORT_CSV && st.lines == 1 && csv_is_header(line)) continue;
+
+        ImportRow row;
+        const char *err = fmt == IMPORT_CSV ? csv_row(line, &row) : jsonl_row(line, &row);
+        if (!err && !validate_marks_and_attendance(row.marks, row.attendance))
+            err = "marks and attendance must be within 0-100";
+        if (err) {
+            report(on_error, ctx, &st, lineno, err);
+            continue;
+        }
+        if (db_search_by_roll(row.roll)) {
+            if (!update_existing) {
+                report(on_error, ctx, &st, lineno, "duplicate roll");
+                continue;
+            }
+            db_update_student(row.roll, row.name, row.marks, row.attendance);
+            ++st.updated;
+            continue;
+        }
+        Student *s = create_student(row.name, row.roll, row.marks, row.attendance);
+        if (!s || !db_add_student(s)) {
+            free_student(s);
+            ok = false;
+            break;
+        }
+        ++st.added;
+    }
+    if (ferror(fp)) ok = false;
+    long consumed = ftell(fp);
+    if (consumed > 0) METRIC_ADD(MET_BYTES_READ, consumed);
+    fclose(fp);
+    METRIC_TIMER_STOP(MET_IMPORT, t0);
+    if (stats) *stats = st;
+    return ok;
+}
@@ -0,0 +1,38 @@
+#ifndef IMPORT_H
+#define IMPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Streaming bulk import of student records from CSV or JSON Lines.
+   Rows are parsed one line at a time into a fixed buffer (no per-row heap use
+   besides the Student itself), validated with validate_marks_and_attendance and
+   inserted with db_add_student (or db_update_student when updating). */
+
+typedef enum {
+    IMPORT_CSV,   /* roll,name,math,physics,chemistry,cs,english,attendance (header line optional) */
+    IMPORT_JSONL  /* {"roll":1,"name":"A","marks":[m1,m2,m3,m4,m5],"attendance":90} per line */
+} ImportFormat;
+
+typedef struct {
+    size_t lines;    /* non-blank lines read, header included */
+    size_t added;
+    size_t updated;
+    size_t rejected; /* rows reported through the error callback */
+} ImportStats;
+
+/* Called once per rejected row with its 1-based line number */
+typedef void (*ImportErrorFn)(size_t line, const char *message, void *ctx);
+
+/* Guess the format from the file extension (.csv, otherwise JSON Lines for
+   .jsonl/.ndjson/.json). Returns false when the extension is not recognized. */
+bool import_format_from_path(const char *path, ImportFormat *fmt);
+
+/* Import every row of path. Rows whose roll already exists are rejected, or
+   overwrite the stored record when update_existing is true. Returns false only
+   when the file cannot be read (or memory runs out); bad rows are reported
+   through on_error (may be NULL) and counted in stats. */
+bool import_file(const char *path, ImportFormat fmt, bool update_existing,
+                 ImportErrorFn on_error, void *ctx, ImportStats *stats);
+
+#endif /* IMPORT_H */
@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "journal.h"
+#include "storage.h"
+#include "metrics.h"
+
+#define JOURNAL_OP_PUT 1
+#define JOURNAL_OP_DELETE 2
+
+/* Fixed-size entry header; a PUT is followed by a JournalPayload */
+typedef struct {
+    uint32_t checksum; /* FNV-1a over op, roll and payload */
+    uint8_t op;
+    uint8_t pad[3];
+    int32_t roll;
+} JournalHeader;
+
+typedef struct {
+    char name[NAME_LEN];
+    double marks[NUM_SUBJECTS];
+    double attendance;
+} JournalPayload;
+
+static FILE *journal_fp = NULL;
+static long journal_bytes = 0;
+static char journal_file[600];
+/* Held wherever journal_fp is replaced or closed, and by journal_sync, which may run
+   on the checkpoint thread; appends stay on the thread that opened the journal. */
+static pthread_mutex_t journal_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t fnv1a(uint32_t h, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    for (size_t i = 0; i < len; ++i) {
+        h ^= p[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+static uint32_t entry_checksum(const JournalHeader *h, const JournalPayload *p) {
+    uint32_t c = fnv1a(2166136261U, &h->op, sizeof(h->op));
+    c = fnv1a(c, &h->roll, sizeof(h->roll));
+    if (p) c = fnv1a(c, p, sizeof(*p));
+    return c;
+}
+
+void journal_path_for(const char *db_filename, char *out, int outlen) {
+    snprintf(out, outlen, "%s.journal", db_filename);
+}
+
+void journal_rotated_path_for(const char *db_filename, char *out, int outlen) {
+    snprintf(out, outlen, "%s.journal.old", db_filename);
+}
+
+static bool open_locked(void) {
+    journal_fp = fopen(journal_file, "ab");
+    if (!journal_fp) return false;
+    fseek(journal_fp, 0, SEEK_END);
+    journal_bytes = ftell(journal_fp);
+    if (journal_bytes < 0) journal_bytes = 0;
+    return true;
+}
+
+static void close_locked(void) {
+    if (journal_fp) fclose(journal_fp);
+    journal_fp = NULL;
+    journal_bytes = 0;
+}
+
+bool journal_open(const char *path) {
+    pthread_mutex_lock(&journal_lock);
+    close_locked();
+    snprintf(journal_file, sizeof(journal_file), "%s", path);
+    bool ok = open_locked();
+    pthread_mutex_unlock(&journal_lock);
+    return ok;
+}
+
+void journal_close(void) {
+    pthread_mutex_lock(&journal_lock);
+    close_locked();
+    pthread_mutex_unlock(&journal_lock);
+}
+
+bool journal_is_open(void) {
+    return journal_fp != NULL;
+}
+
+static bool journal_write(const JournalHeader *h, const JournalPayload *p) {
+    if (!journal_fp) return false;
+    METRIC_TIMER_START(t0);
+    bool ok = fwrite(h, sizeof(*h), 1, journal_fp) == 1 && (!p || fwrite(p, sizeof(*p), 1, journal_fp) == 1) &&
+              fflush(journal_fp) == 0;
+    METRIC_TIMER_STOP(MET_JOURNAL_APPEND, t0);
+    if (!ok) return false;
+    size_t len = sizeof(*h) + (p ? sizeof(*p) : 0);
+    journal_bytes += (long)len;
+    METRIC_ADD(MET_BYTES_WRITTEN, len);
+    return true;
+}
+
+bool journal_log_put(const Student *s) {
+    if (!s) return false;
+    JournalHeader h;
+    JournalPayload p;
+    memset(&h, 0, sizeof(h));
+    memset(&p, 0, sizeof(p));
+    h.op = JOURNAL_OP_PUT;
+    h.roll = s->roll;
+    memcpy(p.name, s->name, strnlen(s->name, NAME_LEN-1)); /* rest stays zero */
+    for (int i = 0; i < NUM_SUBJECTS; ++i) p.marks[i] = s->marks[i];
+    p.attendance = s->attendance;
+    h.checksum = entry_checksum(&h, &p);
+    return journal_write(&h, &p);
+}
+
+bool journal_log_delete(int roll) {
+    JournalHeader h;
+    memset(&h, 0, sizeof(h));
+    h.op = JOURNAL_OP_DELETE;
+    h.roll = roll;
+    h.checksum = entry_checksum(&h, NULL);
+    return journal_write(&h, NULL);
+}
+
+long journal_size(void) {
+    return journal_fp ? journal_bytes : 0;
+}
+
+bool journal_truncate(void) {
+    pthread_mutex_lock(&journal_lock);
+    bool ok = journal_fp != NULL;
+    if (ok) {
+        /* reopen in "wb" to drop every entry, then continue appending */
+        journal_fp = freopen(NULL, "wb", journal_fp);
+        journal_bytes = 0;
+        ok = journal_fp != NULL;
+    }
+    pthread_mutex_unlock(&journal_lock);
+    return ok;
+}
+
+bool journal_sync(void) {
+    pthread_mutex_lock(&journal_lock);
+    bool ok = journal_fp != NULL;
+    if (ok) {
+        METRIC_TIMER_START(t0);
+        ok = storage_sync(journal_fp);
+        METRIC_TIMER_STOP(MET_JOURNAL_SYNC, t0);
+    }
+    pthread_mutex_unlock(&journal_lock);
+    return ok;
+}
+
+bool journal_rotate(const char *old_path) {
+    pthread_mutex_lock(&journal_lock);
+    bool ok = journal_fp != NULL;
+    FILE *existing = ok ? fopen(old_path, "rb") : NULL;
+    if (existing) {
+        /* an earlier rotated journal is still needed; renaming would overwrite it */
+        fclose(existing);
+        ok = false;
+    }
+    if (ok) ok = storage_sync(journal_fp);
+    if (ok) {
+        close_locked();
+        ok = rename(journal_file, old_path) == 0;
+        /* append to a fresh file, or keep the old one if the rename failed */
+        if (!open_locked()) ok = false;
+    }
+    pthread_mutex_unlock(&journal_lock);
+    return ok;
+}
+
+bool journal_replay(const char *path, void (*on_put)(const Student *s), void (*on_delete)(int roll), bool *torn) {
+    if (torn) *torn = false;
+    FILE *f = fopen(path, "rb");
+    if (!f) return true; /* no journal yet */
+
+    JournalHeader h;
+    long good = 0; /* offset just past the last intact entry */
+    while (fread(&h, sizeof(h), 1, f) == 1) {
+        if (h.op == JOURNAL_OP_PUT) {
+            JournalPayload p;
+            if (fread(&p, sizeof(p), 1, f) != 1 || entry_checksum(&h, &p) != h.checksum) break;
+            Student tmp;
+            memset(&tmp, 0, sizeof(tmp));
+            memcpy(tmp.name, p.name, NAME_LEN);
+            tmp.name[NAME_LEN-1] = '\0';
+            tmp.roll = h.roll;
+            for (int i = 0; i < NUM_SUBJECTS; ++i) tmp.marks[i] = p.marks[i];
+            tmp.attendance = p.attendance;
+            tmp.next = NULL;
+            on_put(&tmp);
+        } else if (h.op == JOURNAL_OP_DELETE && entry_checksum(&h, NULL) == h.checksum) {
+            on_delete(h.roll);
+        } else {
+            break;
+        }
+        good = ftell(f);
+    }
+    /* anything after the last intact entry is a torn or corrupt write */
+    fseek(f, 0, SEEK_END);
+    if (torn && ftell(f) != good) *torn = true;
+    METRIC_ADD(MET_BYTES_READ, good);
+    fclose(f);
+    return true;
+}
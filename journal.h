@@ -0,0 +1,50 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "student.h"
+#include <stdbool.h>
+
+/* Append-only write-ahead journal kept next to the snapshot file.
+   Each add/update is logged as a PUT of the full record, each delete as a DELETE of the roll.
+   Replaying the journal over the last snapshot reproduces the in-memory DB. */
+
+/* Build "<db_filename>.journal" into out. */
+void journal_path_for(const char *db_filename, char *out, int outlen);
+
+/* Build "<db_filename>.journal.old", where journal_rotate moves the entries that a
+   background checkpoint is folding into the snapshot. */
+void journal_rotated_path_for(const char *db_filename, char *out, int outlen);
+
+/* Open (create if needed) journal for appending. Returns false on I/O error. */
+bool journal_open(const char *path);
+
+/* Close the journal if open. */
+void journal_close(void);
+
+/* True while a journal is open for appending. */
+bool journal_is_open(void);
+
+/* Append entries (flushed to the OS before returning). */
+bool journal_log_put(const Student *s);
+bool journal_log_delete(int roll);
+
+/* Current journal size in bytes (0 if not open). */
+long journal_size(void);
+
+/* Discard all entries, e.g. after they were folded into a new snapshot. */
+bool journal_truncate(void);
+
+/* fsync the journal so every appended entry survives a crash. Safe to call from
+   another thread while entries are being appended. */
+bool journal_sync(void);
+
+/* fsync, then move the current entries to old_path and continue in an empty journal.
+   Fails without moving anything if old_path already exists. */
+bool journal_rotate(const char *old_path);
+
+/* Replay entries from path in order. on_put receives a temporary record (next == NULL).
+   *torn is set when a partially written or corrupt tail was found and skipped.
+   Returns true if the file is absent or was read successfully. */
+bool journal_replay(const char *path, void (*on_put)(const Student *s), void (*on_delete)(int roll), bool *torn);
+
+#endif /* JOURNAL_H */
@@ -0,0 +1,379 @@
+/* Load generator for server mode (separate program, see README).
+   Opens one connection per client thread, sends a fixed mix of reads and writes
+   for a while at each client count and prints throughput and latency as JSON. */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include "protocol.h"
+
+#define LOADGEN_MAX_CLIENTS 256
+#define LOADGEN_SAMPLES 200000 /* latency samples kept per op and client */
+#define LIST_PAGE 20
+
+typedef enum { L_GET, L_FIND, L_LIST, L_TOP, L_QUERY, L_UPDATE, L_ADD, L_DELETE, L_DUMP, L_OP_COUNT } LoadOp;
+static const char *op_names[L_OP_COUNT] = { "get", "find", "list", "top", "query", "update", "add", "delete", "dump" };
+
+static const char *queries[] = {
+    "attendance < 65", "avg >= 80", "math < 40 and attendance < 75", "below(40) > 1",
+};
+#define COUNT_OF(a) (sizeof(a) / sizeof((a)[0]))
+
+/* target and workload, shared read-only by the clients */
+static const char *sock_path = NULL, *host = NULL;
+static int port = 0;
+static int write_pct = 10;
+static int reporters = 0; /* extra clients doing nothing but full dumps */
+static double run_seconds = 5.0;
+static int *rolls = NULL;
+static char (*prefixes)[4] = NULL;
+static size_t nrolls = 0;
+static atomic_int running; /* 0 = wait, 1 = send, 2 = stop */
+
+typedef struct {
+    int id;
+    uint64_t rng;
+    uint64_t count[L_OP_COUNT];
+    uint64_t errors;
+    uint64_t *samples[L_OP_COUNT];
+    size_t nsamples[L_OP_COUNT];
+    int pending_delete; /* roll added by this client and not yet deleted, or 0 */
+    int next_private;
+    bool reporter;
+} Client;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t rng_next(uint64_t *s) {
+    uint64_t z = (*s += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* Send the request in w and read the reply; returns the status byte or -1 */
+static int round_trip(int fd, ProtoWriter *w, ProtoWriter *in, ProtoReader *r) {
+    if (!proto_send(fd, w) || !proto_recv(fd, in, r)) return -1;
+    return proto_get_u8(r);
+}
+
+static void fill_student(Client *c, Student *s, int roll) {
+    memset(s, 0, sizeof(*s));
+    s->roll = roll;
+    snprintf(s->name, NAME_LEN, "Load Client %d", c->id);
+    for (int i = 0; i < NUM_SUBJECTS; ++i) s->marks[i] = (double)(rng_next(&c->rng) % 201) / 2.0;
+    s->attendance = (double)(rng_next(&c->rng) % 201) / 2.0;
+}
+
+/* A full dump: frames of records until an empty one; returns the status or -1 */
+static int dump_trip(int fd, ProtoWriter *w, ProtoWriter *in, ProtoReader *r) {
+    proto_begin(w);
+    proto_put_u8(w, OP_DUMP);
+    if (!proto_send(fd, w)) return -1;
+    for (;;) {
+        if (!proto_recv(fd, in, r)) return -1;
+        int st = proto_get_u8(r);
+        if (st != PROTO_OK || proto_get_u32(r) == 0) return st;
+    }
+}
+
+/* Build one request of the mix; returns its op */
+static LoadOp build_request(Client *c, ProtoWriter *w) {
+    proto_begin(w);
+    uint64_t dice = rng_next(&c->rng) % 100;
+    int roll = nrolls ? rolls[rng_next(&c->rng) % nrolls] : 1;
+    Student s;
+    if ((int)dice < write_pct) {
+        if (c->pending_delete) {
+            proto_put_u8(w, OP_DELETE);
+            proto_put_i32(w, c->pending_delete);
+            c->pending_delete = 0;
+            return L_DELETE;
+        }
+        if (rng_next(&c->rng) % 2 == 0 || nrolls == 0) {
+            /* private rolls far above the roster, so clients never collide */
+            int fresh = c->next_private++;
+            fill_student(c, &s, fresh);
+            proto_put_u8(w, OP_ADD);
+            proto_put_record(w, &s);
+            c->pending_delete = fresh;
+            return L_ADD;
+        }
+        fill_student(c, &s, roll);
+        s.name[0] = '\0'; /* keep the name */
+        proto_put_u8(w, OP_UPDATE);
+        proto_put_record(w, &s);
+        return L_UPDATE;
+    }
+    dice = rng_next(&c->rng) % 100;
+    if (dice < 70) {
+        proto_put_u8(w, OP_GET);
+        proto_put_i32(w, roll);
+        return L_GET;
+    }
+    if (dice < 80) {
+        proto_put_u8(w, OP_FIND);
+        proto_put_u8(w, NAME_MATCH_PREFIX);
+        proto_put_u32(w, LIST_PAGE);
+        proto_put_str(w, nrolls ? prefixes[rng_next(&c->rng) % nrolls] : "A");
+        return L_FIND;
+    }
+    if (dice < 90) {
+        proto_put_u8(w, OP_LIST);
+        proto_put_i32(w, roll);
+        proto_put_i32(w, INT32_MAX);
+        proto_put_i32(w, 0);
+        proto_put_u8(w, 0);
+        proto_put_u32(w, LIST_PAGE);
+        return L_LIST;
+    }
+    if (dice < 95) {
+        proto_put_u8(w, OP_TOP);
+        proto_put_u8(w, (uint8_t)(rng_next(&c->rng) % (RANK_BY_AVERAGE + 1)));
+        proto_put_u8(w, 1);
+        proto_put_u32(w, 10);
+        return L_TOP;
+    }
+    proto_put_u8(w, OP_QUERY);
+    proto_put_u32(w, LIST_PAGE);
+    proto_put_str(w, queries[rng_next(&c->rng) % COUNT_OF(queries)]);
+    return L_QUERY;
+}
+
+static void *client_main(void *arg) {
+    Client *c = (Client *)arg;
+    int fd = proto_connect(sock_path, host, port);
+    if (fd < 0) {
+        ++c->errors;
+        return NULL;
+    }
+    ProtoWriter w = {0}, in = {0};
+    ProtoReader r;
+    while (atomic_load(&running) == 0) usleep(100);
+    while (atomic_load(&running) == 1) {
+        LoadOp op = c->reporter ? L_DUMP : build_request(c, &w);
+        uint64_t t0 = now_ns();
+        int st = c->reporter ? dump_trip(fd, &w, &in, &r) : round_trip(fd, &w, &in, &r);
+        uint64_t dt = now_ns() - t0;
+        if (st < 0) {
+            ++c->errors;
+            break;
+        }
+        if (st != PROTO_OK && st != PROTO_NOT_FOUND) ++c->errors;
+        ++c->count[op];
+        if (c->nsamples[op] < LOADGEN_SAMPLES) c->samples[op][c->nsamples[op]++] = dt;
+    }
+    if (c->pending_delete) {
+        /* leave the roster as it was */
+        proto_begin(&w);
+        proto_put_u8(&w, OP_DELETE);
+        proto_put_i32(&w, c->pending_delete);
+        round_trip(fd, &w, &in, &r);
+    }
+    proto_writer_free(&w);
+    proto_writer_free(&in);
+    close(fd);
+    return NULL;
+}
+
+/* Every roll on the server and a 3-letter name prefix of each, for the request mix */
+static bool fetch_roster(void) {
+    int fd = proto_connect(sock_path, host, port);
+    if (fd < 0) return false;
+    ProtoWriter w = {0}, in = {0};
+    ProtoReader r;
+    size_t cap = 0;
+    int last = 0;
+    bool after = false, ok = true;
+    for (;;) {
+        proto_begin(&w);
+        proto_put_u8(&w, OP_LIST);
+        proto_put_i32(&w, INT32_MIN);
+        proto_put_i32(&w, INT32_MAX);
+        proto_put_i32(&w, last);
+        proto_put_u8(&w, after);
+        proto_put_u32(&w, PROTO_MAX_RECORDS);
+        if (round_trip(fd, &w, &in, &r) != PROTO_OK) {
+            ok = false;
+            break;
+        }
+        uint32_t n = proto_get_u32(&r);
+        if (n == 0) break;
+        if (nrolls + n > cap) {
+            cap = (nrolls + n) * 2;
+            int *nr = (int *)realloc(rolls, cap * sizeof(int));
+            char (*np)[4] = (char (*)[4])realloc(prefixes, cap * sizeof(*prefixes));
+            if (nr) rolls = nr;
+            if (np) prefixes = np;
+            if (!nr || !np) {
+                ok = false;
+                break;
+            }
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            Student s;
+            if (!proto_get_record(&r, &s)) {
+                ok = false;
+                break;
+            }
+            rolls[nrolls] = s.roll;
+            snprintf(prefixes[nrolls], sizeof(prefixes[0]), "%.3s", s.name);
+            ++nrolls;
+            last = s.roll;
+            after = true;
+        }
+        if (!ok) break;
+    }
+    proto_writer_free(&w);
+    proto_writer_free(&in);
+    close(fd);
+    return ok;
+}
+
+static int cmp_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double pct_us(const uint64_t *v, size_t n, double q) {
+    if (n == 0) return 0.0;
+    size_t i = (size_t)(q * (double)(n - 1));
+    return (double)v[i] / 1e3;
+}
+
+static void run_level(FILE *out, int requesters, bool first) {
+    int clients = requesters + reporters;
+    Client *cs = (Client *)calloc((size_t)clients, sizeof(Client));
+    pthread_t *tids = (pthread_t *)calloc((size_t)clients, sizeof(pthread_t));
+    if (!cs || !tids) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+    atomic_store(&running, 0);
+    for (int i = 0; i < clients; ++i) {
+        cs[i].id = i;
+        cs[i].rng = 0x5EED0000ULL + (uint64_t)i * 7919;
+        cs[i].next_private = 2000000000 - (i + 1) * 1000000;
+        cs[i].reporter = i >= requesters;
+        for (int op = 0; op < L_OP_COUNT; ++op) {
+            cs[i].samples[op] = (uint64_t *)malloc(sizeof(uint64_t) * LOADGEN_SAMPLES);
+            if (!cs[i].samples[op]) {
+                fprintf(stderr, "out of memory\n");
+                exit(1);
+            }
+        }
+        pthread_create(&tids[i], NULL, client_main, &cs[i]);
+    }
+    uint64_t t0 = now_ns();
+    atomic_store(&running, 1);
+    while ((double)(now_ns() - t0) / 1e9 < run_seconds) usleep(10000);
+    atomic_store(&running, 2);
+    for (int i = 0; i < clients; ++i) pthread_join(tids[i], NULL);
+    double secs = (double)(now_ns() - t0) / 1e9;
+
+    uint64_t total = 0, errors = 0;
+    for (int i = 0; i < clients; ++i) {
+        errors += cs[i].errors;
+        for (int op = 0; op < L_DUMP; ++op) total += cs[i].count[op]; /* dumps are reported on their own */
+    }
+    fprintf(out, "%s\n    {\"clients\": %d, \"reporters\": %d, \"seconds\": %.3f, \"requests\": %llu, \"errors\": %llu, \"rps\": %.1f, \"ops\": {",
+            first ? "" : ",", requesters, reporters, secs, (unsigned long long)total, (unsigned long long)errors, (double)total / secs);
+    fprintf(stderr, "  clients=%-4d %10.1f req/s  errors=%llu\n", requesters, (double)total / secs,
+            (unsigned long long)errors);
+    bool first_op = true;
+    for (int op = 0; op < L_OP_COUNT; ++op) {
+        size_t n = 0;
+        uint64_t count = 0;
+        for (int i = 0; i < clients; ++i) {
+            n += cs[i].nsamples[op];
+            count += cs[i].count[op];
+        }
+        if (count == 0) continue;
+        uint64_t *all = (uint64_t *)malloc(sizeof(uint64_t) * (n ? n : 1));
+        size_t k = 0;
+        for (int i = 0; i < clients && all; ++i) {
+            memcpy(all + k, cs[i].samples[op], cs[i].nsamples[op] * sizeof(uint64_t));
+            k += cs[i].nsamples[op];
+        }
+        if (all) qsort(all, n, sizeof(uint64_t), cmp_u64);
+        fprintf(out, "%s\n      \"%s\": {\"count\": %llu, \"p50_us\": %.1f, \"p99_us\": %.1f, \"max_us\": %.1f}",
+                first_op ? "" : ",", op_names[op], (unsigned long long)count, all ? pct_us(all, n, 0.50) : 0.0,
+                all ? pct_us(all, n, 0.99) : 0.0, all && n ? (double)all[n - 1] / 1e3 : 0.0);
+        first_op = false;
+        free(all);
+    }
+    fprintf(out, "\n    }}");
+    for (int i = 0; i < clients; ++i)
+        for (int op = 0; op < L_OP_COUNT; ++op) free(cs[i].samples[op]);
+    free(cs);
+    free(tids);
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--socket PATH | --port N [--host ADDR]] [--clients 1,2,4,8] [--seconds S]\n"
+                    "          [--writes PCT] [--reporters N] [--out FILE]\n"
+                    "Runs the request mix at each client count against a running 'student_app serve';\n"
+                    "--reporters adds clients that only request full dumps.\n",
+            prog);
+}
+
+int main(int argc, char **argv) {
+    const char *clients_arg = "1,2,4,8", *out_path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (i + 1 < argc && strcmp(argv[i], "--socket") == 0) sock_path = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--port") == 0) port = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--host") == 0) host = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--clients") == 0) clients_arg = argv[++i];
+        else if (i + 1 < argc && strcmp(argv[i], "--seconds") == 0) run_seconds = atof(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--writes") == 0) write_pct = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--reporters") == 0) reporters = atoi(argv[++i]);
+        else if (i + 1 < argc && strcmp(argv[i], "--out") == 0) out_path = argv[++i];
+        else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!sock_path && port == 0) sock_path = "srms.sock";
+    if (run_seconds <= 0 || write_pct < 0 || write_pct > 100 || reporters < 0 || reporters > LOADGEN_MAX_CLIENTS) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (!fetch_roster()) {
+        fprintf(stderr, "cannot reach the server at %s\n", sock_path ? sock_path : "the given port");
+        return 1;
+    }
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", out_path);
+        return 1;
+    }
+    fprintf(out, "{\n  \"benchmark\": \"srms-server\",\n  \"students\": %zu,\n  \"write_pct\": %d,\n  \"results\": [",
+            nrolls, write_pct);
+    bool first = true;
+    for (const char *p = clients_arg; *p;) {
+        int n = atoi(p);
+        if (n < 1 || n > LOADGEN_MAX_CLIENTS) {
+            fprintf(stderr, "client counts must be 1-%d\n", LOADGEN_MAX_CLIENTS);
+            return 1;
+        }
+        run_level(out, n, first);
+        first = false;
+        fflush(out);
+        p = strchr(p, ',');
+        if (!p) break;
+        ++p;
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out_path) fclose(out);
+    free(rolls);
+    free(prefixes);
+    return 0;
+}
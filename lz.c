@@ -0,0 +1,111 @@
+#include <string.h>
+#include <stdint.h>
+#include "lz.h"
+
+#define MIN_MATCH 4
+#define MAX_OFFSET 65535
+#define HASH_BITS 14
+
+static uint32_t read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static uint32_t hash4(uint32_t v) {
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/* Write the extra bytes of a length whose nibble was 15 */
+static unsigned char *put_length(unsigned char *op, const unsigned char *oend, size_t len) {
+    for (; len >= 255; len -= 255) {
+        if (op >= oend) return NULL;
+        *op++ = 255;
+    }
+    if (op >= oend) return NULL;
+    *op++ = (unsigned char)len;
+    return op;
+}
+
+/* One sequence: literals [lit, lit + nlit), then a match (omitted when mlen == 0) */
+static unsigned char *put_sequence(unsigned char *op, const unsigned char *oend, const unsigned char *lit,
+                                   size_t nlit, size_t offset, size_t mlen) {
+    if (op >= oend) return NULL;
+    unsigned char *token = op++;
+    size_t mcode = mlen ? mlen - MIN_MATCH : 0;
+    *token = (unsigned char)(((nlit < 15 ? nlit : 15) << 4) | (mcode < 15 ? mcode : 15));
+    if (nlit >= 15 && !(op = put_length(op, oend, nlit - 15))) return NULL;
+    if ((size_t)(oend - op) < nlit) return NULL;
+    memcpy(op, lit, nlit);
+    op += nlit;
+    if (mlen == 0) return op;
+    if (oend - op < 2) return NULL;
+    *op++ = (unsigned char)offset;
+    *op++ = (unsigned char)(offset >> 8);
+    if (mcode >= 15 && !(op = put_length(op, oend, mcode - 15))) return NULL;
+    return op;
+}
+
+size_t lz_compress(const unsigned char *in, size_t n, unsigned char *out, size_t cap) {
+    uint32_t table[1u << HASH_BITS]; /* position + 1 of the last 4 bytes with this hash */
+    memset(table, 0, sizeof(table));
+    const unsigned char *ip = in, *anchor = in, *end = in + n;
+    unsigned char *op = out, *oend = out + cap;
+    while (n >= MIN_MATCH && ip <= end - MIN_MATCH) {
+        uint32_t seq = read32(ip);
+        uint32_t h = hash4(seq);
+        size_t ref = table[h];
+        table[h] = (uint32_t)(ip - in) + 1;
+        if (ref == 0 || (size_t)(ip - in) + 1 - ref > MAX_OFFSET || read32(in + ref - 1) != seq) {
+            ++ip;
+            continue;
+        }
+        const unsigned char *m = in + ref - 1;
+        size_t len = MIN_MATCH;
+        while (ip + len < end && m[len] == ip[len]) ++len;
+        op = put_sequence(op, oend, anchor, (size_t)(ip - anchor), (size_t)(ip - m), len);
+        if (!op) return 0;
+        ip += len;
+        anchor = ip;
+    }
+    op = put_sequence(op, oend, anchor, (size_t)(end - anchor), 0, 0);
+    return op ? (size_t)(op - out) : 0;
+}
+
+/* Read the extra bytes of a length whose nibble was 15 */
+static bool get_length(const unsigned char **ip, const unsigned char *iend, size_t *len) {
+    unsigned char b;
+    do {
+        if (*ip >= iend) return false;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return true;
+}
+
+bool lz_decompress(const unsigned char *in, size_t n, unsigned char *out, size_t out_len) {
+    const unsigned char *ip = in, *iend = in + n;
+    size_t pos = 0;
+    while (ip < iend) {
+        unsigned token = *ip++;
+        size_t nlit = token >> 4;
+        if (nlit == 15 && !get_length(&ip, iend, &nlit)) return false;
+        if ((size_t)(iend - ip) < nlit || out_len - pos < nlit) return false;
+        memcpy(out + pos, ip, nlit);
+        ip += nlit;
+        pos += nlit;
+        if (ip == iend) break; /* the last sequence has no match */
+        if (iend - ip < 2) return false;
+        size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+        ip += 2;
+        size_t mlen = token & 15;
+        if (mlen == 15 && !get_length(&ip, iend, &mlen)) return false;
+        mlen += MIN_MATCH;
+        if (offset == 0 || offset > pos || out_len - pos < mlen) return false;
+        /* byte by byte: the match may overlap the bytes it produces */
+        const unsigned char *src = out + pos - offset;
+        for (size_t i = 0; i < mlen; ++i) out[pos + i] = src[i];
+        pos += mlen;
+    }
+    return pos == out_len;
+}
@@ -0,0 +1,21 @@
+#ifndef LZ_H
+#define LZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Small LZ77 block codec for snapshot blocks (storage.c); no external library.
+   A block is a series of sequences: a token byte (literal count in the high
+   nibble, match length - 4 in the low one, 15 meaning more length bytes follow,
+   each adding up to 255), the literals, then a 2-byte little-endian offset back
+   into the output and any extra match length bytes. The last sequence has
+   literals only. Matches are found with a 4-byte hash table, greedily. */
+
+/* Compress n bytes of in into out (cap bytes). Returns the compressed size, or 0 if
+   it would not fit in cap (store the block uncompressed then). */
+size_t lz_compress(const unsigned char *in, size_t n, unsigned char *out, size_t cap);
+
+/* Decompress exactly out_len bytes. Returns false on malformed or truncated input. */
+bool lz_decompress(const unsigned char *in, size_t n, unsigned char *out, size_t out_len);
+
+#endif /* LZ_H */
@@ -2,11 +2,24 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
 #include "student.h"
 #include "database.h"
 #include "openai_ai.h"
+#include "columns.h"
+#include "ai_cache.h"
+#include "ai_model.h"
+#include "query.h"
+#include "import.h"
+#include "export.h"
+#include "metrics.h"
+#include "server.h"
 
 #define DB_FILENAME "students.dat"
+#define AI_CACHE_FILENAME "ai_cache.dat"
+#define AI_MODEL_FILENAME "ai_model.bin"
+#define GROUP_COMMIT_MS 100 /* default fsync interval of the checkpoint thread */
+#define SERVER_SOCKET "srms.sock"
 
 /* Read a line from stdin and trim newline */
 static void read_line(char *buf, int size) {
@@ -69,9 +82,9 @@ static void ui_add_student(void) {
     }
     if (!db_add_student(s)) {
         printf("Failed to add student: maybe roll number already exists.\n");
-        free(s);
+        free_student(s);
     } else {
-        if (!db_save(DB_FILENAME)) {
+        if (!db_commit()) {
             printf("Warning: failed to save database to file.\n");
         }
         printf("Student added successfully.\n");
@@ -81,7 +94,7 @@ static void ui_add_student(void) {
 /* Update existing */
 static void ui_update_student(void) {
     int roll = read_int_prompt("Enter roll number to update: ");
-    Student *s = db_search_by_roll(roll);
+    const Student *s = db_search_by_roll(roll);
     if (!s) {
         printf("Student with roll %d not found.\n", roll);
         return;
@@ -119,7 +132,7 @@ static void ui_update_student(void) {
     }
     const char *newnameptr = (strlen(name) == 0) ? NULL : name;
     if (db_update_student(roll, newnameptr, marks, attendance)) {
-        if (!db_save(DB_FILENAME)) printf("Warning: failed to save database.\n");
+        if (!db_commit()) printf("Warning: failed to save database.\n");
         printf("Student updated successfully.\n");
     } else {
         printf("Failed to update student.\n");
@@ -130,54 +143,347 @@ static void ui_update_student(void) {
 static void ui_delete_student(void) {
     int roll = read_int_prompt("Enter roll number to delete: ");
     if (db_delete_by_roll(roll)) {
-        if (!db_save(DB_FILENAME)) printf("Warning: failed to save database.\n");
+        if (!db_commit()) printf("Warning: failed to save database.\n");
         printf("Student deleted.\n");
     } else {
         printf("Student with roll %d not found.\n", roll);
     }
 }
 
+#define SEARCH_SHOW_MAX 50
+
 /* Search and display */
 static void ui_search_student(void) {
-    printf("Search by: 1) Roll  2) Name\nChoose option: ");
+    printf("Search by: 1) Roll  2) Exact name  3) Name (ignore case)  4) Name prefix\nChoose option: ");
     int opt = read_int_prompt("");
     if (opt == 1) {
         int roll = read_int_prompt("Enter roll: ");
-        Student *s = db_search_by_roll(roll);
+        const Student *s = db_search_by_roll(roll);
         if (s) print_student(s);
         else printf("Not found.\n");
     } else {
         char name[NAME_LEN];
-        printf("Enter exact name: ");
+        NameMatch mode = (opt == 4) ? NAME_MATCH_PREFIX : (opt == 3 ? NAME_MATCH_CASE_INSENSITIVE : NAME_MATCH_EXACT);
+        printf(mode == NAME_MATCH_PREFIX ? "Enter name prefix: " : "Enter name: ");
         read_line(name, sizeof(name));
-        Student *s = db_search_by_name(name);
-        if (s) print_student(s);
-        else printf("Not found.\n");
+        Student found[SEARCH_SHOW_MAX];
+        int n = db_find_by_name(name, mode, found, SEARCH_SHOW_MAX);
+        if (n == 0) {
+            printf("Not found.\n");
+            return;
+        }
+        for (int i = 0; i < n && i < SEARCH_SHOW_MAX; ++i) print_student(&found[i]);
+        if (n > SEARCH_SHOW_MAX) printf("... and %d more matches.\n", n - SEARCH_SHOW_MAX);
+        else printf("%d match%s.\n", n, n == 1 ? "" : "es");
     }
 }
 
-/* List all */
+/* Export format from a file name: .csv, .jsonl/.ndjson/.json, anything else pretty text */
+static ExportFormat export_format_for(const char *path) {
+    ImportFormat f;
+    if (!import_format_from_path(path, &f)) return EXPORT_PRETTY;
+    return f == IMPORT_CSV ? EXPORT_CSV : EXPORT_JSONL;
+}
+
+static void ui_export(void) {
+    char path[256];
+    printf("Output file (.csv, .jsonl, or other for the listing layout): ");
+    read_line(path, sizeof(path));
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        printf("Cannot open '%s' for writing.\n", path);
+        return;
+    }
+    size_t n;
+    bool ok = export_students(fp, export_format_for(path), 0, &n);
+    if (fclose(fp) != 0) ok = false;
+    if (ok) printf("Exported %zu students to %s.\n", n, path);
+    else printf("Export to %s failed.\n", path);
+}
+
+#define LIST_PAGE_SIZE 20
+
+/* List all, or page through a roll range */
 static void ui_list_all(void) {
-    db_print_all();
+    printf("List: 1) All students  2) Roll range (paged)  3) Export all to a file\n");
+    int opt = read_int_prompt("Choose option: ");
+    if (opt == 3) {
+        ui_export();
+        return;
+    }
+    if (opt != 2) {
+        if (db_count() == 0) printf("No student records available.\n");
+        else export_students(stdout, EXPORT_PRETTY, 1, NULL);
+        return;
+    }
+    int lo = read_int_prompt("From roll: ");
+    int hi = read_int_prompt("To roll: ");
+    DbCursor cur = DB_CURSOR_INIT;
+    Student page[LIST_PAGE_SIZE];
+    int total = 0, n;
+    while ((n = db_list_range(lo, hi, &cur, page, LIST_PAGE_SIZE)) > 0) {
+        for (int i = 0; i < n; ++i) print_student(&page[i]);
+        total += n;
+        if (n < LIST_PAGE_SIZE) break;
+        char buf[16];
+        printf("-- %d shown; Enter for next page, q to stop: ", total);
+        read_line(buf, sizeof(buf));
+        if (buf[0] == 'q' || buf[0] == 'Q') break;
+    }
+    if (total == 0) printf("No students with roll %d-%d.\n", lo, hi);
 }
 
 /* AI actions: predict risk and suggest career for a student */
 static void ui_ai_module(void) {
     int roll = read_int_prompt("Enter roll number for AI analysis: ");
-    Student *s = db_search_by_roll(roll);
+    const Student *s = db_search_by_roll(roll);
     if (!s) {
         printf("Student not found.\n");
         return;
     }
-    char explanation[256];
-    ai_explain(s, explanation, sizeof(explanation));
-    RiskLevel r = ai_predict_risk(s);
-    const char *risk_text = (r == RISK_HIGH) ? "HIGH" : (r == RISK_MEDIUM ? "MEDIUM" : "LOW");
-    const char *career = ai_suggest_career(s);
+    AiResult r;
+    ai_analyze(s, &r);
     printf("AI Analysis for %s (Roll %d):\n", s->name, s->roll);
-    printf("Risk Level      : %s\n", risk_text);
-    printf("Suggested field : %s\n", career);
-    printf("Explanation     : %s\n", explanation);
+    printf("Risk Level      : %s\n", ai_risk_to_string(r.risk));
+    printf("Suggested field : %s\n", r.career);
+    printf("Explanation     : %s\n", r.explanation);
+    AiCacheStats cs;
+    ai_cache_stats(&cs);
+    printf("Result source   : %s in %.1lf ms (cache: %llu hits, %llu misses, %zu entries)\n",
+           ai_source_to_string(r.source), r.latency_ms,
+           (unsigned long long)cs.hits, (unsigned long long)cs.misses, cs.entries);
+}
+
+/* Class-wide summary per subject and attendance distribution */
+static void ui_class_stats(void) {
+    if (db_count() == 0) {
+        printf("No student records available.\n");
+        return;
+    }
+    const char *labels[DB_FIELD_COUNT] = {"Mathematics", "Physics", "Chemistry", "ComputerScience", "English", "Attendance", "Average"};
+    DbStats st[DB_FIELD_COUNT];
+    printf("%-16s %8s %8s %8s %8s\n", "Column", "Mean", "Min", "Max", "StdDev");
+    for (int f = 0; f < DB_FIELD_COUNT; ++f) {
+        db_stats(f, &st[f]);
+        printf("%-16s %8.2lf %8.2lf %8.2lf %8.2lf\n", labels[f], st[f].mean, st[f].min, st[f].max, st[f].stddev);
+    }
+    printf("Attendance distribution (%zu students):\n", st[DB_FIELD_ATTENDANCE].count);
+    for (int b = 0; b < DB_STAT_BINS; ++b)
+        printf("  %3d-%-3d%% : %zu\n", b * 10, b == 9 ? 100 : b * 10 + 9, st[DB_FIELD_ATTENDANCE].hist[b]);
+    printf("Local risk estimate: LOW %zu, MEDIUM %zu, HIGH %zu\n",
+           db_band_count(RISK_LOW), db_band_count(RISK_MEDIUM), db_band_count(RISK_HIGH));
+}
+
+#define RANK_SHOW_MAX 100
+
+/* Top/bottom K by average, subject or attendance, or one student's rank */
+static void ui_rankings(void) {
+    if (db_count() == 0) {
+        printf("No student records available.\n");
+        return;
+    }
+    printf("Rank by: 1) Average  2) Subject  3) Attendance\n");
+    int by = read_int_prompt("Choose option: ");
+    int key = RANK_BY_AVERAGE;
+    if (by == 2) {
+        printf("Subjects: 1) Mathematics 2) Physics 3) Chemistry 4) ComputerScience 5) English\n");
+        int sub = read_int_prompt("Subject: ");
+        if (sub < 1 || sub > NUM_SUBJECTS) {
+            printf("Invalid subject.\n");
+            return;
+        }
+        key = sub - 1;
+    } else if (by == 3) {
+        key = RANK_BY_ATTENDANCE;
+    }
+    printf("1) Top K  2) Bottom K  3) Rank of a student\n");
+    int opt = read_int_prompt("Choose option: ");
+    if (opt == 3) {
+        int roll = read_int_prompt("Roll number: ");
+        int rank;
+        size_t total;
+        if (db_rank_of(roll, key, &rank, &total)) printf("Roll %d is ranked %d of %zu.\n", roll, rank, total);
+        else printf("Student not found.\n");
+        return;
+    }
+    int k = read_int_prompt("K: ");
+    if (k <= 0) return;
+    if (k > RANK_SHOW_MAX) k = RANK_SHOW_MAX;
+    Student top[RANK_SHOW_MAX];
+    int n = db_top_k(key, opt != 2, k, top);
+    for (int i = 0; i < n; ++i) {
+        double v = key == RANK_BY_AVERAGE ? student_average(&top[i])
+                 : key == RANK_BY_ATTENDANCE ? top[i].attendance : top[i].marks[key];
+        printf("%4d. %-8d %-24.24s %8.2lf\n", i + 1, top[i].roll, top[i].name, v);
+    }
+}
+
+#define FILTER_SHOW_MAX 50
+
+/* Run a filter query and print the matches (at most FILTER_SHOW_MAX); returns false on a bad query */
+static bool run_filter(const char *text) {
+    Query q;
+    char err[96];
+    if (!query_parse(text, &q, err, sizeof(err))) {
+        printf("Invalid query: %s\n", err);
+        return false;
+    }
+    Student found[FILTER_SHOW_MAX];
+    size_t n = query_run(&q, found, FILTER_SHOW_MAX);
+    if (n == (size_t)-1) {
+        printf("Query failed (out of memory).\n");
+        return false;
+    }
+    for (size_t i = 0; i < n && i < FILTER_SHOW_MAX; ++i)
+        printf("%-8d %-24.24s avg %6.2lf  attendance %6.2lf\n", found[i].roll, found[i].name,
+               student_average(&found[i]), found[i].attendance);
+    if (n > FILTER_SHOW_MAX) printf("... and %zu more.\n", n - FILTER_SHOW_MAX);
+    printf("%zu match%s.\n", n, n == 1 ? "" : "es");
+    return true;
+}
+
+static void ui_filter(void) {
+    char text[256];
+    printf("Fields: math physics chemistry cs english attendance avg below(<marks>)\n");
+    printf("Example: attendance < 65 and below(40) > 2\n");
+    printf("Query: ");
+    read_line(text, sizeof(text));
+    run_filter(text);
+}
+
+/* Batch selection: which students to send */
+typedef struct {
+    Student *list;   /* copies: db_foreach's Student lives only for the callback */
+    int count;
+    int mode;        /* 1 all, 2 average below, 3 attendance below */
+    double threshold;
+} BatchSelection;
+
+static void collect_for_batch(const Student *s, void *ctx) {
+    BatchSelection *sel = (BatchSelection *)ctx;
+    if (sel->mode == 2 && student_average(s) >= sel->threshold) return;
+    if (sel->mode == 3 && s->attendance >= sel->threshold) return;
+    sel->list[sel->count++] = *s;
+}
+
+static void print_batch_result(const Student *s, const AiResult *r, void *ctx) {
+    int *risk_counts = (int *)ctx;
+    /* counted the way ai_risk_to_string prints it, so a bad value cannot index past the array */
+    ++risk_counts[r->risk == RISK_HIGH || r->risk == RISK_MEDIUM ? r->risk : RISK_LOW];
+    printf("%-8d %-24.24s %-6s %-22.22s %s\n", s->roll, s->name, ai_risk_to_string(r->risk), r->career,
+           ai_source_to_string(r->source));
+    fflush(stdout);
+}
+
+/* AI analysis for the whole roster or a filtered subset, streamed as results arrive */
+static void ui_ai_batch(void) {
+    if (db_count() == 0) {
+        printf("No student records available.\n");
+        return;
+    }
+    BatchSelection sel = { NULL, 0, 1, 0.0 };
+    printf("Analyze: 1) All students  2) Average below threshold  3) Attendance below threshold\n");
+    sel.mode = read_int_prompt("Choose option: ");
+    if (sel.mode == 2 || sel.mode == 3) sel.threshold = read_double_prompt("Threshold: ");
+    AiBatchOptions opt;
+    opt.max_concurrency = read_int_prompt("Max concurrent requests (0 = default 8): ");
+    opt.requests_per_minute = read_int_prompt("Requests per minute limit (0 = unlimited): ");
+
+    size_t total = db_count();
+    sel.list = (Student *)malloc(sizeof(Student) * total);
+    const Student **ptrs = (const Student **)malloc(sizeof(Student *) * total);
+    if (!sel.list || !ptrs) {
+        printf("Memory allocation failed.\n");
+        free(sel.list);
+        free(ptrs);
+        return;
+    }
+    db_foreach(collect_for_batch, &sel);
+    for (int i = 0; i < sel.count; ++i) ptrs[i] = &sel.list[i];
+    int risk_counts[3] = {0, 0, 0};
+    printf("%-8s %-24s %-6s %-22s %s\n", "Roll", "Name", "Risk", "Career", "Source");
+    int answered = ai_analyze_batch(ptrs, sel.count, &opt, print_batch_result, risk_counts);
+    printf("Analyzed %d students (%d by AI/cache): %d HIGH, %d MEDIUM, %d LOW risk.\n",
+           sel.count, answered, risk_counts[RISK_HIGH], risk_counts[RISK_MEDIUM], risk_counts[RISK_LOW]);
+    free(ptrs);
+    free(sel.list);
+}
+
+/* Band function for the class risk counts */
+static int local_risk_band(const Student *s) {
+    return (int)ai_local_risk(s);
+}
+
+/* Local model: train, compare with remote answers, predict the whole roster */
+static void ui_local_model(void) {
+    printf("Local model: 1) Train from CSV  2) Train from cached AI answers  3) Agreement with AI  4) Predict all students\n");
+    int opt = read_int_prompt("Choose option: ");
+    if (opt == 1 || opt == 2) {
+        long n;
+        if (opt == 1) {
+            char path[256];
+            printf("CSV file (math,physics,chemistry,cs,english,attendance,risk[,career]): ");
+            read_line(path, sizeof(path));
+            n = ai_model_train_csv(path);
+        } else {
+            n = ai_model_train_from_cache();
+        }
+        if (n < 0) {
+            printf("Training failed (no usable samples or unreadable file).\n");
+            return;
+        }
+        printf("Trained on %ld samples.\n", n);
+        db_set_band_fn(local_risk_band, RISK_HIGH + 1); /* risk counts follow the new model */
+        if (!ai_model_save(AI_MODEL_FILENAME)) printf("Warning: failed to save model file.\n");
+    } else if (opt == 3) {
+        AiModelAgreement a;
+        if (!ai_model_agreement(&a)) {
+            printf("No local model loaded.\n");
+            return;
+        }
+        if (a.samples == 0) {
+            printf("No cached AI answers to compare against.\n");
+            return;
+        }
+        printf("Risk agreement   : %zu / %zu (%.1lf%%)\n", a.risk_agree, a.samples, 100.0 * a.risk_agree / a.samples);
+        if (a.career_samples)
+            printf("Career agreement : %zu / %zu (%.1lf%%)\n", a.career_agree, a.career_samples, 100.0 * a.career_agree / a.career_samples);
+    } else if (opt == 4) {
+        size_t n = col_count();
+        if (n == 0) {
+            printf("No student records available.\n");
+            return;
+        }
+        unsigned char *risk = (unsigned char *)malloc(n);
+        if (!risk) {
+            printf("Memory allocation failed.\n");
+            return;
+        }
+        clock_t t0 = clock();
+        if (!ai_model_predict_roster(risk, NULL)) {
+            printf("No local model loaded.\n");
+            free(risk);
+            return;
+        }
+        double secs = (double)(clock() - t0) / CLOCKS_PER_SEC;
+        size_t counts[3] = {0, 0, 0};
+        for (size_t i = 0; i < n; ++i) ++counts[risk[i]];
+        printf("Predicted %zu students in %.3lf ms (%.1lf ns/student): %zu HIGH, %zu MEDIUM, %zu LOW risk.\n",
+               n, secs * 1e3, secs * 1e9 / (double)n, counts[RISK_HIGH], counts[RISK_MEDIUM], counts[RISK_LOW]);
+        free(risk);
+    } else {
+        printf("Invalid option.\n");
+    }
+}
+
+static void ui_metrics(void) {
+    printf("\n");
+    metrics_dump(stdout);
+    int opt = read_int_prompt("1 = reset, 0 = keep: ");
+    if (opt == 1) {
+        metrics_reset();
+        printf("Metrics reset.\n");
+    }
 }
 
 /* Print menu */
@@ -189,16 +495,211 @@ static void print_menu(void) {
     printf("4. Search Student\n");
     printf("5. List all Students\n");
     printf("6. AI Analysis for Student (Risk + Career Suggestion)\n");
-    printf("7. Exit\n");
+    printf("7. Class Statistics\n");
+    printf("8. AI Batch Analysis (all or filtered students)\n");
+    printf("9. Local AI Model (train / agreement / predict all)\n");
+    printf("10. Rankings (top/bottom K, rank of student)\n");
+    printf("11. Filter Students (query, e.g. attendance < 65 and below(40) > 2)\n");
+    printf("12. Performance Metrics (latency percentiles, I/O counters)\n");
+    printf("13. Exit\n");
     printf("----------------------------------------\n");
 }
 
+/* --- non-interactive subcommands --- */
+
+/* Interactive and server sessions checkpoint in the background. $SRMS_DURABILITY
+   picks when a change is on disk: "interval" (default, every $SRMS_GROUP_COMMIT_MS
+   ms), "immediate" (before the menu or the server replies) or "exit". */
+static void start_checkpointing(void) {
+    DbDurability mode = DB_DURABLE_INTERVAL;
+    const char *env = getenv("SRMS_DURABILITY");
+    if (env && strcmp(env, "immediate") == 0) mode = DB_DURABLE_IMMEDIATE;
+    else if (env && strcmp(env, "exit") == 0) mode = DB_DURABLE_ON_EXIT;
+    else if (env && strcmp(env, "interval") != 0) fprintf(stderr, "Warning: unknown SRMS_DURABILITY '%s'.\n", env);
+    int interval = getenv("SRMS_GROUP_COMMIT_MS") ? atoi(getenv("SRMS_GROUP_COMMIT_MS")) : GROUP_COMMIT_MS;
+    if (interval <= 0) interval = GROUP_COMMIT_MS;
+    if (!db_checkpoint_start(mode, interval)) {
+        fprintf(stderr, "Warning: no checkpoint thread; snapshots will be written synchronously.\n");
+    }
+}
+
+#define IMPORT_ERRORS_SHOWN 100
+
+typedef struct {
+    const char *path;
+    size_t shown;
+} ImportErrorLog;
+
+static void print_import_error(size_t line, const char *message, void *ctx) {
+    ImportErrorLog *log = (ImportErrorLog *)ctx;
+    if (log->shown++ < IMPORT_ERRORS_SHOWN) fprintf(stderr, "%s:%zu: %s\n", log->path, line, message);
+}
+
+static void cli_usage(const char *prog) {
+    fprintf(stderr,
+            "Usage:\n"
+            "  %s                                   interactive menu\n"
+            "  %s import FILE [--format csv|jsonl] [--update]\n"
+            "                                       bulk import, saved once at the end\n"
+            "  %s query \"EXPR\"                      list students matching a filter\n"
+            "  %s export [FILE] [--format csv|jsonl|pretty] [--threads N]\n"
+            "                                       write all students (stdout without FILE)\n"
+            "  %s serve [--socket PATH | --port N] [--threads N]\n"
+            "                                       serve many clients (default socket " SERVER_SOCKET ")\n",
+            prog, prog, prog, prog, prog);
+}
+
+/* import FILE [--format csv|jsonl] [--update]; exit 0 = all rows in, 2 = some rejected, 1 = failed */
+static int cli_import(int argc, char **argv) {
+    const char *path = NULL;
+    bool update = false, have_format = false;
+    ImportFormat fmt = IMPORT_CSV;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            ++i;
+            if (strcmp(argv[i], "csv") == 0) fmt = IMPORT_CSV;
+            else if (strcmp(argv[i], "jsonl") == 0) fmt = IMPORT_JSONL;
+            else {
+                fprintf(stderr, "Unknown format '%s' (use csv or jsonl).\n", argv[i]);
+                return 1;
+            }
+            have_format = true;
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            cli_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!path) {
+        cli_usage(argv[0]);
+        return 1;
+    }
+    if (!have_format && !import_format_from_path(path, &fmt)) {
+        fprintf(stderr, "Cannot tell the format of '%s'; pass --format csv or --format jsonl.\n", path);
+        return 1;
+    }
+    ImportErrorLog log = { path, 0 };
+    ImportStats st;
+    clock_t t0 = clock();
+    db_bulk_begin();
+    bool read_ok = import_file(path, fmt, update, print_import_error, &log, &st);
+    /* rows already inserted are kept even if reading stopped early */
+    bool saved = db_bulk_end();
+    double secs = (double)(clock() - t0) / CLOCKS_PER_SEC;
+    if (log.shown > IMPORT_ERRORS_SHOWN) fprintf(stderr, "... %zu more errors not shown.\n", log.shown - IMPORT_ERRORS_SHOWN);
+    if (!read_ok) fprintf(stderr, "Import stopped: cannot read '%s' or out of memory.\n", path);
+    if (!saved) fprintf(stderr, "Failed to save %s.\n", DB_FILENAME);
+    printf("Imported %zu new, %zu updated, %zu rejected (%zu students total), %.2f s CPU.\n",
+           st.added, st.updated, st.rejected, db_count(), secs);
+    if (!read_ok || !saved) return 1;
+    return st.rejected ? 2 : 0;
+}
+
+/* export [FILE] [--format csv|jsonl|pretty] [--threads N] */
+static int cli_export(int argc, char **argv) {
+    const char *path = NULL;
+    bool have_format = false;
+    ExportFormat fmt = EXPORT_CSV;
+    int threads = 0;
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            if (!export_format_from_name(argv[++i], &fmt)) {
+                fprintf(stderr, "Unknown format '%s' (use csv, jsonl or pretty).\n", argv[i]);
+                return 1;
+            }
+            have_format = true;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            cli_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (path && !have_format) fmt = export_format_for(path);
+    FILE *fp = path ? fopen(path, "wb") : stdout;
+    if (!fp) {
+        fprintf(stderr, "Cannot open '%s' for writing.\n", path);
+        return 1;
+    }
+    size_t n;
+    bool ok = export_students(fp, fmt, threads, &n);
+    if (path && fclose(fp) != 0) ok = false;
+    if (!ok) fprintf(stderr, "Export failed after %zu students.\n", n);
+    else if (path) fprintf(stderr, "Exported %zu students to %s.\n", n, path);
+    return ok ? 0 : 1;
+}
+
+/* serve [--socket PATH | --port N] [--threads N]: runs until SIGINT/SIGTERM */
+static int cli_serve(int argc, char **argv) {
+    ServerOptions opt = { NULL, 0, 0 };
+    for (int i = 2; i < argc; ++i) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            opt.socket_path = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            opt.port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            opt.threads = atoi(argv[++i]);
+        } else {
+            cli_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!opt.socket_path && opt.port == 0) opt.socket_path = SERVER_SOCKET;
+    start_checkpointing();
+    int status = server_run(&opt);
+    if (!db_checkpoint_stop()) fprintf(stderr, "Warning: a background save failed; saving again.\n");
+    if (!db_save(DB_FILENAME)) {
+        fprintf(stderr, "Failed to save %s.\n", DB_FILENAME);
+        status = 1;
+    }
+    return status;
+}
+
+/* Runs a subcommand and returns its exit status, or -1 when argv asks for the menu */
+static int run_cli(int argc, char **argv) {
+    if (argc < 2) return -1;
+    if (strcmp(argv[1], "import") == 0) return cli_import(argc, argv);
+    if (strcmp(argv[1], "query") == 0 && argc == 3) return run_filter(argv[2]) ? 0 : 1;
+    if (strcmp(argv[1], "export") == 0) return cli_export(argc, argv);
+    if (strcmp(argv[1], "serve") == 0) return cli_serve(argc, argv);
+    cli_usage(argv[0]);
+    return 1;
+}
+
 /* Main loop */
-int main(void) {
+int main(int argc, char **argv) {
+    atexit(metrics_dump_env); /* SRMS_METRICS_FILE=path (or -) dumps the metrics on exit */
     if (!db_load(DB_FILENAME)) {
-        printf("Warning: failed to load database file. Starting with empty DB.\n");
+        fprintf(stderr, "Warning: failed to load database file. Starting with empty DB.\n");
+    }
+    if (!col_buckets_enable(true)) {
+        fprintf(stderr, "Warning: not enough memory for the filter bitmap index; queries will scan.\n");
+    }
+    if (!ai_cache_open(AI_CACHE_FILENAME)) {
+        fprintf(stderr, "Warning: AI result cache file unusable; caching in memory only.\n");
     }
+    db_set_change_hook(ai_cache_invalidate_roll);
+    ai_model_load(AI_MODEL_FILENAME); /* optional; heuristic fallback without it */
+    db_set_band_fn(local_risk_band, RISK_HIGH + 1);
+    AiLatencyBudget budget;
+    ai_get_latency_budget(&budget);
+    if (getenv("SRMS_AI_DEADLINE_MS")) budget.deadline_ms = atoi(getenv("SRMS_AI_DEADLINE_MS"));
+    if (getenv("SRMS_AI_HEDGE_MS")) budget.hedge_delay_ms = atoi(getenv("SRMS_AI_HEDGE_MS"));
+    ai_set_latency_budget(&budget);
 
+    int status = run_cli(argc, argv);
+    if (status >= 0) {
+        db_free_all();
+        ai_cache_close();
+        return status;
+    }
+
+    start_checkpointing();
     while (1) {
         print_menu();
         int choice = read_int_prompt("Enter choice: ");
@@ -209,11 +710,21 @@ int main(void) {
             case 4: ui_search_student(); break;
             case 5: ui_list_all(); break;
             case 6: ui_ai_module(); break;
-            case 7:
+            case 7: ui_class_stats(); break;
+            case 8: ui_ai_batch(); break;
+            case 9: ui_local_model(); break;
+            case 10: ui_rankings(); break;
+            case 11: ui_filter(); break;
+            case 12: ui_metrics(); break;
+            case 13:
+                if (!db_checkpoint_stop()) {
+                    printf("Warning: a background save failed; saving again.\n");
+                }
                 if (!db_save(DB_FILENAME)) {
                     printf("Warning: failed to save database on exit.\n");
                 }
                 db_free_all();
+                ai_cache_close();
                 printf("Exiting. Goodbye!\n");
                 return 0;
             default:
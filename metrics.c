@@ -0,0 +1,178 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdatomic.h>
+#include "metrics.h"
+
+/* Log-linear (HDR-style) buckets: values below 8 ns get their own bucket, above
+   that each power of two is split into 8 sub-buckets (relative error <= 1/8). */
+#define SUB_BITS 3
+#define SUB_COUNT (1 << SUB_BITS)
+#define BUCKETS ((64 - SUB_BITS + 1) * SUB_COUNT)
+
+typedef struct {
+    _Atomic uint64_t total_ns; /* the count is the sum of the buckets */
+    _Atomic uint64_t max_ns;
+    _Atomic uint64_t buckets[BUCKETS];
+} Histogram;
+
+static Histogram hists[MET_OP_COUNT];
+_Thread_local unsigned metrics_sample_tick = 0;
+static _Atomic uint64_t counters[MET_COUNTER_COUNT];
+
+static const char *op_names[] = {
+    "db_load", "db_save", "db_commit", "db_add_student", "db_update_student", "db_delete_by_roll",
+    "db_search_by_roll", "db_search_by_name", "db_find_by_name", "db_foreach", "db_print_all",
+    "db_list_range", "db_top_k", "db_rank_of", "db_stats", "db_checkpoint", "journal_append", "journal_sync",
+    "query_run", "import_file", "export_students", "server_request", "ai_http_round_trip", "ai_analyze", "ai_analyze_batch"
+};
+
+static const char *counter_names[] = {
+    "records_scanned", "bytes_read", "bytes_written"
+};
+_Static_assert(sizeof(op_names) / sizeof(op_names[0]) == MET_OP_COUNT, "one name per MetricOp");
+_Static_assert(sizeof(counter_names) / sizeof(counter_names[0]) == MET_COUNTER_COUNT, "one name per counter");
+
+const char *metrics_op_name(MetricOp op) {
+    return (op >= 0 && op < MET_OP_COUNT) ? op_names[op] : "?";
+}
+
+const char *metrics_counter_name(MetricCounter c) {
+    return (c >= 0 && c < MET_COUNTER_COUNT) ? counter_names[c] : "?";
+}
+
+uint64_t metrics_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int bucket_of(uint64_t v) {
+    if (v < SUB_COUNT) return (int)v;
+    int msb = 63 - __builtin_clzll(v);
+    int shift = msb - SUB_BITS;
+    return (shift + 1) * SUB_COUNT + (int)((v >> shift) & (SUB_COUNT - 1));
+}
+
+/* Largest value that falls in bucket b */
+static uint64_t bucket_upper(int b) {
+    if (b < SUB_COUNT) return (uint64_t)b;
+    int shift = b / SUB_COUNT - 1;
+    uint64_t lower = (uint64_t)(SUB_COUNT + b % SUB_COUNT) << shift;
+    return lower + (((uint64_t)1 << shift) - 1);
+}
+
+void metrics_record(MetricOp op, uint64_t ns) {
+    metrics_record_weighted(op, ns, 1);
+}
+
+void metrics_record_weighted(MetricOp op, uint64_t ns, uint64_t weight) {
+    if (op < 0 || op >= MET_OP_COUNT) return;
+    Histogram *h = &hists[op];
+    atomic_fetch_add_explicit(&h->total_ns, ns * weight, memory_order_relaxed);
+    atomic_fetch_add_explicit(&h->buckets[bucket_of(ns)], weight, memory_order_relaxed);
+    uint64_t cur = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+    while (ns > cur && !atomic_compare_exchange_weak_explicit(&h->max_ns, &cur, ns, memory_order_relaxed,
+                                                              memory_order_relaxed)) {}
+}
+
+void metrics_add(MetricCounter c, uint64_t n) {
+    if (c < 0 || c >= MET_COUNTER_COUNT) return;
+    atomic_fetch_add_explicit(&counters[c], n, memory_order_relaxed);
+}
+
+uint64_t metrics_counter(MetricCounter c) {
+    if (c < 0 || c >= MET_COUNTER_COUNT) return 0;
+    return atomic_load_explicit(&counters[c], memory_order_relaxed);
+}
+
+static uint64_t percentile(const uint64_t *snap, uint64_t count, uint64_t max, double q) {
+    uint64_t target = (uint64_t)(q * (double)count);
+    if (target == 0) target = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        seen += snap[b];
+        if (seen >= target) {
+            uint64_t up = bucket_upper(b);
+            return up < max ? up : max;
+        }
+    }
+    return max;
+}
+
+bool metrics_summary(MetricOp op, MetricSummary *out) {
+    if (op < 0 || op >= MET_OP_COUNT || !out) return false;
+    Histogram *h = &hists[op];
+    static uint64_t snap[BUCKETS]; /* summaries are read from one thread (menu/exit) */
+    uint64_t count = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        snap[b] = atomic_load_explicit(&h->buckets[b], memory_order_relaxed);
+        count += snap[b];
+    }
+    memset(out, 0, sizeof(*out));
+    out->count = count;
+    if (count == 0) return true;
+    out->total_ns = atomic_load_explicit(&h->total_ns, memory_order_relaxed);
+    out->max_ns = atomic_load_explicit(&h->max_ns, memory_order_relaxed);
+    out->p50_ns = percentile(snap, count, out->max_ns, 0.50);
+    out->p90_ns = percentile(snap, count, out->max_ns, 0.90);
+    out->p99_ns = percentile(snap, count, out->max_ns, 0.99);
+    out->p999_ns = percentile(snap, count, out->max_ns, 0.999);
+    return true;
+}
+
+void metrics_reset(void) {
+    for (int op = 0; op < MET_OP_COUNT; ++op) {
+        Histogram *h = &hists[op];
+        atomic_store_explicit(&h->total_ns, 0, memory_order_relaxed);
+        atomic_store_explicit(&h->max_ns, 0, memory_order_relaxed);
+        for (int b = 0; b < BUCKETS; ++b) atomic_store_explicit(&h->buckets[b], 0, memory_order_relaxed);
+    }
+    for (int c = 0; c < MET_COUNTER_COUNT; ++c) atomic_store_explicit(&counters[c], 0, memory_order_relaxed);
+}
+
+/* Print a duration with a unit that keeps 3-4 significant digits */
+static void fmt_ns(char *buf, size_t len, uint64_t ns) {
+    if (ns < 10000) snprintf(buf, len, "%lluns", (unsigned long long)ns);
+    else if (ns < 10000000) snprintf(buf, len, "%.1fus", (double)ns / 1e3);
+    else if (ns < 10000000000ull) snprintf(buf, len, "%.1fms", (double)ns / 1e6);
+    else snprintf(buf, len, "%.2fs", (double)ns / 1e9);
+}
+
+void metrics_dump(FILE *out) {
+#ifdef SRMS_NO_METRICS
+    fprintf(out, "Metrics were compiled out (SRMS_NO_METRICS).\n");
+    return;
+#endif
+    fprintf(out, "%-20s %10s %10s %10s %10s %10s %10s %10s\n", "operation", "count", "mean", "p50", "p90", "p99",
+            "p99.9", "max");
+    for (int op = 0; op < MET_OP_COUNT; ++op) {
+        MetricSummary s;
+        metrics_summary((MetricOp)op, &s);
+        if (s.count == 0) continue;
+        char mean[16], p50[16], p90[16], p99[16], p999[16], mx[16];
+        fmt_ns(mean, sizeof(mean), s.total_ns / s.count);
+        fmt_ns(p50, sizeof(p50), s.p50_ns);
+        fmt_ns(p90, sizeof(p90), s.p90_ns);
+        fmt_ns(p99, sizeof(p99), s.p99_ns);
+        fmt_ns(p999, sizeof(p999), s.p999_ns);
+        fmt_ns(mx, sizeof(mx), s.max_ns);
+        fprintf(out, "%-20s %10llu %10s %10s %10s %10s %10s %10s\n", op_names[op], (unsigned long long)s.count, mean,
+                p50, p90, p99, p999, mx);
+    }
+    for (int c = 0; c < MET_COUNTER_COUNT; ++c)
+        fprintf(out, "%-20s %10llu\n", counter_names[c], (unsigned long long)metrics_counter((MetricCounter)c));
+}
+
+void metrics_dump_env(void) {
+    const char *path = getenv("SRMS_METRICS_FILE");
+    if (!path || !*path) return;
+    if (strcmp(path, "-") == 0) {
+        metrics_dump(stderr);
+        return;
+    }
+    FILE *fp = fopen(path, "w");
+    if (!fp) return;
+    metrics_dump(fp);
+    fclose(fp);
+}
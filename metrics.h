@@ -0,0 +1,102 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Latency histograms and counters for database operations, file I/O and AI calls.
+   Build with -DSRMS_NO_METRICS to compile every probe out (the macros below then
+   expand to nothing). Otherwise each probe is two monotonic clock reads and a few
+   relaxed atomic adds, safe to call from any thread. */
+
+typedef enum {
+    MET_DB_LOAD,
+    MET_DB_SAVE,
+    MET_DB_COMMIT,
+    MET_DB_ADD,
+    MET_DB_UPDATE,
+    MET_DB_DELETE,
+    MET_DB_SEARCH_ROLL,
+    MET_DB_SEARCH_NAME,
+    MET_DB_FIND_NAME,
+    MET_DB_FOREACH,
+    MET_DB_PRINT_ALL,
+    MET_DB_LIST_RANGE,
+    MET_DB_TOP_K,
+    MET_DB_RANK_OF,
+    MET_DB_STATS,
+    MET_DB_CHECKPOINT, /* background snapshot write, see db_checkpoint_start */
+    MET_JOURNAL_APPEND,
+    MET_JOURNAL_SYNC,
+    MET_QUERY,
+    MET_IMPORT,
+    MET_EXPORT,
+    MET_SERVER_REQUEST, /* one request in server mode, lock wait included */
+    MET_AI_HTTP,    /* one remote round trip (including a hedged second request) */
+    MET_AI_ANALYZE, /* ai_analyze end to end, cache and fallback included */
+    MET_AI_BATCH,
+    MET_OP_COUNT
+} MetricOp;
+
+typedef enum {
+    MET_RECORDS_SCANNED,
+    MET_BYTES_READ,
+    MET_BYTES_WRITTEN,
+    MET_COUNTER_COUNT
+} MetricCounter;
+
+/* Summary of one operation's histogram (nanoseconds; percentiles are bucket
+   upper bounds, within 1/8 of the true value) */
+typedef struct {
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t p50_ns;
+    uint64_t p90_ns;
+    uint64_t p99_ns;
+    uint64_t p999_ns;
+} MetricSummary;
+
+const char *metrics_op_name(MetricOp op);
+const char *metrics_counter_name(MetricCounter c);
+
+void metrics_record(MetricOp op, uint64_t ns);
+void metrics_record_weighted(MetricOp op, uint64_t ns, uint64_t weight);
+void metrics_add(MetricCounter c, uint64_t n);
+uint64_t metrics_now_ns(void);
+
+bool metrics_summary(MetricOp op, MetricSummary *out);
+uint64_t metrics_counter(MetricCounter c);
+void metrics_reset(void);
+
+/* Table of every operation seen so far plus the counters. */
+void metrics_dump(FILE *out);
+
+/* If $SRMS_METRICS_FILE is set, write metrics_dump there ("-" = stderr).
+   Meant for atexit(). */
+void metrics_dump_env(void);
+
+/* Operations of a few dozen nanoseconds cannot afford a clock read per call (the
+   read also waits for the loads in flight), so the sampled timer times one call
+   in METRIC_SAMPLE_EVERY and records it with that weight. */
+#define METRIC_SAMPLE_EVERY 64
+extern _Thread_local unsigned metrics_sample_tick;
+
+#ifndef SRMS_NO_METRICS
+#define METRIC_TIMER_START(var) uint64_t var = metrics_now_ns()
+#define METRIC_TIMER_STOP(op, var) metrics_record((op), metrics_now_ns() - (var))
+#define METRIC_SAMPLED_START(var) \
+    uint64_t var = (++metrics_sample_tick & (METRIC_SAMPLE_EVERY - 1)) == 0 ? metrics_now_ns() : 0
+#define METRIC_SAMPLED_STOP(op, var) \
+    ((var) ? metrics_record_weighted((op), metrics_now_ns() - (var), METRIC_SAMPLE_EVERY) : (void)0)
+#define METRIC_ADD(counter, n) metrics_add((counter), (uint64_t)(n))
+#else
+#define METRIC_TIMER_START(var) ((void)0)
+#define METRIC_TIMER_STOP(op, var) ((void)0)
+#define METRIC_SAMPLED_START(var) ((void)0)
+#define METRIC_SAMPLED_STOP(op, var) ((void)0)
+#define METRIC_ADD(counter, n) ((void)sizeof(n)) /* not evaluated */
+#endif
+
+#endif /* METRICS_H */
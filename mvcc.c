@@ -0,0 +1,202 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "mvcc.h"
+
+/* Radix tree over rows: LEVELS inner levels of NODE_FAN children above leaves of
+   LEAF_ROWS records, so a row is found in LEVELS + 1 steps. */
+#define LEAF_BITS 5
+#define LEAF_ROWS (1u << LEAF_BITS)
+#define NODE_BITS 6
+#define NODE_FAN (1u << NODE_BITS)
+#define LEVELS 4
+#define MAX_ROWS ((size_t)LEAF_ROWS << (NODE_BITS * LEVELS)) /* 2^29 */
+#define MAX_READERS 128
+
+/* Every node starts with the generation it was written in. A node of an older
+   generation belongs to a published version and is copied before it is changed. */
+typedef struct {
+    uint64_t gen;
+} NodeHead;
+
+typedef struct {
+    NodeHead h;
+    void *child[NODE_FAN];
+} Inner;
+
+typedef struct {
+    NodeHead h;
+    Student rec[LEAF_ROWS];
+} Leaf;
+
+struct MvccVersion {
+    void *root;
+    size_t count;
+};
+
+/* Something a pinned reader may still see, freed once every reader is past epoch */
+typedef struct {
+    void *p;
+    uint64_t epoch; /* 0 until the version that last held it is replaced */
+} Retired;
+
+/* writer state */
+static void *work_root = NULL;
+static size_t work_count = 0;
+static uint64_t work_gen = 1;
+static bool work_dirty = true; /* an empty database is a version too */
+static bool work_failed = false;
+static Retired *retired = NULL;
+static size_t retired_n = 0, retired_cap = 0;
+
+/* shared with readers */
+static _Atomic(MvccVersion *) published = NULL;
+static _Atomic uint64_t global_epoch = 1;
+static _Atomic uint64_t reader_epoch[MAX_READERS]; /* epoch a reader pinned at, 0 = free */
+
+static bool retire_reserve(size_t extra) {
+    if (retired_n + extra <= retired_cap) return true;
+    size_t ncap = retired_cap ? retired_cap * 2 : 256;
+    while (ncap < retired_n + extra) ncap *= 2;
+    Retired *r = (Retired *)realloc(retired, ncap * sizeof(Retired));
+    if (!r) return false;
+    retired = r;
+    retired_cap = ncap;
+    return true;
+}
+
+/* The node at *slot, made writable: a fresh node if there is none, a copy (the
+   original is retired) if a published version can see it. */
+static void *own(void **slot, size_t size) {
+    NodeHead *n = (NodeHead *)*slot;
+    if (n && n->gen == work_gen) return n;
+    if (n && !retire_reserve(1)) return NULL;
+    NodeHead *copy = (NodeHead *)(n ? malloc(size) : calloc(1, size));
+    if (!copy) return NULL;
+    if (n) {
+        memcpy(copy, n, size);
+        retired[retired_n++] = (Retired){ n, 0 };
+    }
+    copy->gen = work_gen;
+    *slot = copy;
+    return copy;
+}
+
+bool mvcc_set(size_t row, const Student *s) {
+    if (work_failed) return false;
+    work_dirty = true;
+    void **slot = &work_root;
+    for (int l = LEVELS - 1; row < MAX_ROWS && l >= 0; --l) {
+        Inner *n = (Inner *)own(slot, sizeof(Inner));
+        if (!n) break;
+        slot = &n->child[(row >> (LEAF_BITS + NODE_BITS * l)) & (NODE_FAN - 1)];
+        if (l > 0) continue;
+        Leaf *leaf = (Leaf *)own(slot, sizeof(Leaf));
+        if (!leaf) break;
+        Student *r = &leaf->rec[row & (LEAF_ROWS - 1)];
+        *r = *s;
+        r->next = NULL;
+        return true;
+    }
+    /* the working version no longer matches the database: publish nothing from now on */
+    work_failed = true;
+    return false;
+}
+
+void mvcc_set_count(size_t count) {
+    if (count == work_count) return;
+    work_count = count;
+    work_dirty = true;
+}
+
+/* Free retired nodes and versions older than every pinned reader */
+static void reclaim(void) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < MAX_READERS; ++i) {
+        uint64_t e = atomic_load(&reader_epoch[i]);
+        if (e && e < oldest) oldest = e;
+    }
+    size_t keep = 0;
+    for (size_t i = 0; i < retired_n; ++i) {
+        if (retired[i].epoch && retired[i].epoch < oldest) free(retired[i].p);
+        else retired[keep++] = retired[i];
+    }
+    retired_n = keep;
+}
+
+void mvcc_publish(void) {
+    if (!work_dirty || !retire_reserve(1)) return;
+    MvccVersion *v = NULL;
+    if (!work_failed) {
+        v = (MvccVersion *)malloc(sizeof(MvccVersion));
+        if (!v) return; /* try again at the next publish */
+        v->root = work_root;
+        v->count = work_count;
+    }
+    MvccVersion *old = atomic_exchange(&published, v);
+    /* a reader pinned at this epoch or earlier may hold old, or the nodes replaced
+       since it was published; readers pinning later see v */
+    uint64_t e = atomic_load(&global_epoch);
+    if (old) retired[retired_n++] = (Retired){ old, 0 };
+    for (size_t i = 0; i < retired_n; ++i)
+        if (retired[i].epoch == 0) retired[i].epoch = e;
+    atomic_store(&global_epoch, e + 1);
+    ++work_gen; /* v's nodes are read-only from now on */
+    work_dirty = false;
+    reclaim();
+}
+
+static void free_tree(void *n, int level) {
+    if (!n) return;
+    if (level >= 0)
+        for (unsigned i = 0; i < NODE_FAN; ++i) free_tree(((Inner *)n)->child[i], level - 1);
+    free(n);
+}
+
+void mvcc_reset(void) {
+    /* every node is either in the working tree or retired, never both */
+    free_tree(work_root, LEVELS - 1);
+    for (size_t i = 0; i < retired_n; ++i) free(retired[i].p);
+    free(retired);
+    free(atomic_exchange(&published, NULL));
+    work_root = NULL;
+    work_count = 0;
+    work_dirty = true;
+    work_failed = false;
+    retired = NULL;
+    retired_n = retired_cap = 0;
+}
+
+const MvccVersion *mvcc_pin(int *reader) {
+    for (int i = 0; i < MAX_READERS; ++i) {
+        uint64_t e = atomic_load(&global_epoch), idle = 0;
+        /* announce the epoch before reading the version: the writer frees nothing a
+           reader announced at this epoch could reach */
+        if (!atomic_compare_exchange_strong(&reader_epoch[i], &idle, e)) continue;
+        const MvccVersion *v = atomic_load(&published);
+        if (!v) {
+            atomic_store(&reader_epoch[i], 0);
+            return NULL;
+        }
+        *reader = i;
+        return v;
+    }
+    return NULL;
+}
+
+void mvcc_unpin(int reader) {
+    if (reader >= 0 && reader < MAX_READERS) atomic_store(&reader_epoch[reader], 0);
+}
+
+size_t mvcc_count(const MvccVersion *v) {
+    return v ? v->count : 0;
+}
+
+const Student *mvcc_get(const MvccVersion *v, size_t row) {
+    if (!v || row >= v->count) return NULL;
+    const void *n = v->root;
+    for (int l = LEVELS - 1; n && l >= 0; --l)
+        n = ((const Inner *)n)->child[(row >> (LEAF_BITS + NODE_BITS * l)) & (NODE_FAN - 1)];
+    return n ? &((const Leaf *)n)->rec[row & (LEAF_ROWS - 1)] : NULL;
+}
@@ -0,0 +1,45 @@
+#ifndef MVCC_H
+#define MVCC_H
+
+#include "student.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Versioned copy of every record, by column row (maintained by database.c).
+   The writer changes a private working version; mvcc_publish freezes it, and from
+   then on any thread may pin it and read it without locks while the writer goes
+   on. Versions share unchanged parts: the rows live in a radix tree whose nodes
+   are copied on the first write after a publish (copy-on-write), so a publish costs
+   one small copy per changed leaf. Replaced nodes are freed by epoch-based
+   reclamation once no reader that could still see them is pinned. */
+
+typedef struct MvccVersion MvccVersion;
+
+/* --- writer side (one thread at a time, e.g. under the database lock) --- */
+
+/* Store a copy of s (next is cleared) at row, which may lie past the current count.
+   On allocation failure the store stops publishing until mvcc_reset. */
+bool mvcc_set(size_t row, const Student *s);
+
+/* Rows 0..count-1 are part of the next version. */
+void mvcc_set_count(size_t count);
+
+/* Make the working version visible to mvcc_pin (no-op if nothing changed), then free
+   what no pinned reader can reach any more. */
+void mvcc_publish(void);
+
+/* Free every version. No reader may be pinned. */
+void mvcc_reset(void);
+
+/* --- readers (any thread) --- */
+
+/* Pin the latest published version; returns NULL when there is none or too many
+   readers are pinned. *reader identifies the pin for mvcc_unpin. */
+const MvccVersion *mvcc_pin(int *reader);
+void mvcc_unpin(int reader);
+
+size_t mvcc_count(const MvccVersion *v);
+/* Record at row (row < mvcc_count(v)); valid until the version is unpinned. */
+const Student *mvcc_get(const MvccVersion *v, size_t row);
+
+#endif /* MVCC_H */
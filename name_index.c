@@ -0,0 +1,175 @@
+#include <stdlib.h>
+#include <ctype.h>
+#include "name_index.h"
+
+/* Nodes and roll entries live in growable arrays and link by index (-1 = none).
+   Freed nodes and entries are chained on free lists and reused. */
+typedef struct {
+    int first_child;
+    int next_sibling;
+    int rolls;          /* head of this node's roll entry list */
+    unsigned char ch;
+} TrieNode;
+
+typedef struct {
+    int roll;
+    int next;
+} RollEntry;
+
+static TrieNode *nodes = NULL;
+static int node_count = 0, node_cap = 0, node_free = -1; /* free nodes chain through next_sibling */
+static RollEntry *entries = NULL;
+static int entry_count = 0, entry_cap = 0, entry_free = -1;
+
+static unsigned char fold(char c) {
+    return (unsigned char)tolower((unsigned char)c);
+}
+
+#define PRUNE_DEPTH 128 /* longer names are removed without pruning their path */
+
+static int new_node(unsigned char ch) {
+    int id = node_free;
+    if (id >= 0) {
+        node_free = nodes[id].next_sibling;
+    } else {
+        if (node_count == node_cap) {
+            int ncap = node_cap ? node_cap * 2 : 1024;
+            TrieNode *n = (TrieNode *)realloc(nodes, sizeof(TrieNode) * (size_t)ncap);
+            if (!n) return -1;
+            nodes = n;
+            node_cap = ncap;
+        }
+        id = node_count++;
+    }
+    TrieNode *t = &nodes[id];
+    t->first_child = t->next_sibling = t->rolls = -1;
+    t->ch = ch;
+    return id;
+}
+
+static int find_child(int parent, unsigned char ch) {
+    for (int c = nodes[parent].first_child; c >= 0; c = nodes[c].next_sibling)
+        if (nodes[c].ch == ch) return c;
+    return -1;
+}
+
+/* Node for the folded name, optionally creating the path */
+static int walk(const char *name, bool create) {
+    if (node_count == 0) {
+        if (!create || new_node(0) < 0) return -1;
+    }
+    int cur = 0;
+    for (const char *p = name; *p; ++p) {
+        unsigned char ch = fold(*p);
+        int nxt = find_child(cur, ch);
+        if (nxt < 0) {
+            if (!create) return -1;
+            nxt = new_node(ch);
+            if (nxt < 0) return -1;
+            nodes[nxt].next_sibling = nodes[cur].first_child;
+            nodes[cur].first_child = nxt;
+        }
+        cur = nxt;
+    }
+    return cur;
+}
+
+bool name_index_add(const char *name, int roll) {
+    int node = walk(name, true);
+    if (node < 0) return false;
+    int e = entry_free;
+    if (e >= 0) {
+        entry_free = entries[e].next;
+    } else {
+        if (entry_count == entry_cap) {
+            int ncap = entry_cap ? entry_cap * 2 : 1024;
+            RollEntry *n = (RollEntry *)realloc(entries, sizeof(RollEntry) * (size_t)ncap);
+            if (!n) return false;
+            entries = n;
+            entry_cap = ncap;
+        }
+        e = entry_count++;
+    }
+    entries[e].roll = roll;
+    entries[e].next = nodes[node].rolls;
+    nodes[node].rolls = e;
+    return true;
+}
+
+void name_index_remove(const char *name, int roll) {
+    if (node_count == 0) return;
+    int path[PRUNE_DEPTH]; /* ancestors of node, root first */
+    int depth = 0, node = 0;
+    bool deep = false;
+    for (const char *p = name; *p; ++p) {
+        if (depth < PRUNE_DEPTH) path[depth++] = node;
+        else deep = true;
+        node = find_child(node, fold(*p));
+        if (node < 0) return;
+    }
+    for (int *link = &nodes[node].rolls; *link >= 0; link = &entries[*link].next) {
+        int e = *link;
+        if (entries[e].roll == roll) {
+            *link = entries[e].next;
+            entries[e].next = entry_free;
+            entry_free = e;
+            break;
+        }
+    }
+    if (deep) return;
+    /* prune nodes left with neither rolls nor children, bottom up (never the root) */
+    while (depth > 0 && nodes[node].rolls < 0 && nodes[node].first_child < 0) {
+        int parent = path[--depth];
+        int *link = &nodes[parent].first_child;
+        while (*link != node) link = &nodes[*link].next_sibling;
+        *link = nodes[node].next_sibling;
+        nodes[node].next_sibling = node_free;
+        node_free = node;
+        node = parent;
+    }
+}
+
+void name_index_clear(void) {
+    free(nodes);
+    free(entries);
+    nodes = NULL;
+    entries = NULL;
+    node_count = node_cap = entry_count = entry_cap = 0;
+    node_free = entry_free = -1;
+}
+
+/* Depth-first visit of every roll in the subtree; returns false if fn stopped it */
+static bool visit_subtree(int root, bool (*fn)(int roll, void *ctx), void *ctx) {
+    int stack_small[64];
+    int *stack = stack_small, cap = 64, top = 0;
+    bool go = true;
+    stack[top++] = root;
+    while (top > 0 && go) {
+        int n = stack[--top];
+        for (int e = nodes[n].rolls; e >= 0 && go; e = entries[e].next) go = fn(entries[e].roll, ctx);
+        for (int c = nodes[n].first_child; c >= 0; c = nodes[c].next_sibling) {
+            if (top == cap) {
+                int *ns = (int *)malloc(sizeof(int) * (size_t)cap * 2);
+                if (!ns) { go = false; break; }
+                for (int i = 0; i < top; ++i) ns[i] = stack[i];
+                if (stack != stack_small) free(stack);
+                stack = ns;
+                cap *= 2;
+            }
+            stack[top++] = c;
+        }
+    }
+    if (stack != stack_small) free(stack);
+    return go;
+}
+
+void name_index_lookup(const char *query, bool prefix, bool (*fn)(int roll, void *ctx), void *ctx) {
+    int node = walk(query, false);
+    if (node < 0) return;
+    if (prefix) {
+        visit_subtree(node, fn, ctx);
+        return;
+    }
+    for (int e = nodes[node].rolls; e >= 0; e = entries[e].next)
+        if (!fn(entries[e].roll, ctx)) return;
+}
@@ -0,0 +1,18 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include <stdbool.h>
+
+/* Trie over case-folded student names mapping to roll numbers (maintained by database.c).
+   Lookups walk one trie level per query character, so their cost depends on the
+   query length (plus the number of matches reported), not on the number of records. */
+
+bool name_index_add(const char *name, int roll);
+void name_index_remove(const char *name, int roll);
+void name_index_clear(void);
+
+/* Visit the rolls whose folded name equals the folded query (prefix == false) or
+   starts with it (prefix == true). Stops early when fn returns false. */
+void name_index_lookup(const char *query, bool prefix, bool (*fn)(int roll, void *ctx), void *ctx);
+
+#endif /* NAME_INDEX_H */
@@ -2,13 +2,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <time.h>
 #include <curl/curl.h>
 #include "openai_ai.h"
 #include "student.h"
+#include "ai_cache.h"
+#include "ai_model.h"
+#include "metrics.h"
 #include <cjson/cJSON.h>
 
 #define OPENAI_URL "https://api.openai.com/v1/chat/completions"
 #define MODEL_NAME "gpt-4o-mini"
+#define PROMPT_VERSION 1 /* bump whenever the prompt below changes, to miss old cache entries */
 #define BUF_SMALL 512
 #define BUF_LARGE 4096
 
@@ -36,24 +41,29 @@ static void student_to_json(const Student *s, char *out, int outlen) {
              s->roll, s->name, marks, s->attendance);
 }
 
-static char *call_openai_for_student(const char *student_json) {
-    const char *key = getenv("OPENAI_API_KEY");
-    if (!key) return NULL;
+static char endpoint_override[512] = "";
 
-    CURL *curl = curl_easy_init();
-    if (!curl) return NULL;
+void ai_set_endpoint(const char *url) {
+    snprintf(endpoint_override, sizeof(endpoint_override), "%s", url ? url : "");
+}
 
-    struct mem resp = { .ptr = malloc(1), .len = 0 };
-    curl_easy_setopt(curl, CURLOPT_URL, OPENAI_URL);
+/* Chat Completions URL: ai_set_endpoint, else $SRMS_AI_URL, else OPENAI_URL */
+static const char *ai_endpoint(void) {
+    if (endpoint_override[0]) return endpoint_override;
+    const char *env = getenv("SRMS_AI_URL");
+    return (env && env[0]) ? env : OPENAI_URL;
+}
 
+static struct curl_slist *build_headers(const char *key) {
     struct curl_slist *hdrs = NULL;
     hdrs = curl_slist_append(hdrs, "Content-Type: application/json");
     char auth[512]; snprintf(auth, sizeof(auth), "Authorization: Bearer %s", key);
     hdrs = curl_slist_append(hdrs, auth);
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hdrs);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &resp);
+    return hdrs;
+}
 
+/* Serialized Chat Completions request for one student (caller frees) */
+static char *build_request_body(const char *student_json) {
     /* Build request with clearer system instructions and few-shot examples.
        We force JSON-only output, provide an allowed career list, and set temperature=0
        so results are deterministic and less likely to default to "engineering". */
@@ -123,20 +133,12 @@ static char *call_openai_for_student(const char *student_json) {
     cJSON_AddItemToObject(root, "messages", messages);
     char *body = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
+    return body;
+}
 
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body);
-    CURLcode res = curl_easy_perform(curl);
-    free(body);
-    curl_slist_free_all(hdrs);
-    curl_easy_cleanup(curl);
-
-    if (res != CURLE_OK) {
-        free(resp.ptr);
-        return NULL;
-    }
-
-    /* Parse assistant reply similar to previous logic */
-    cJSON *j = cJSON_Parse(resp.ptr);
+/* Pull the assistant message text out of a Chat Completions response (caller frees) */
+static char *extract_assistant_text(const char *response) {
+    cJSON *j = cJSON_Parse(response);
     char *assistant_text = NULL;
     if (j) {
         cJSON *choices = cJSON_GetObjectItem(j, "choices");
@@ -153,7 +155,150 @@ static char *call_openai_for_student(const char *student_json) {
         }
         cJSON_Delete(j);
     }
-    free(resp.ptr);
+    return assistant_text;
+}
+
+static AiLatencyBudget budget = { 8000, 3000, 2500, 95 };
+
+#define LATENCY_SAMPLES 128
+#define LATENCY_MIN_SAMPLES 20
+
+static double latency_ring[LATENCY_SAMPLES]; /* recent successful round trips, ms */
+static int latency_n = 0, latency_pos = 0;
+
+void ai_set_latency_budget(const AiLatencyBudget *b) {
+    if (b) budget = *b;
+}
+
+void ai_get_latency_budget(AiLatencyBudget *b) {
+    if (b) *b = budget;
+}
+
+static long long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void record_latency(double ms) {
+    latency_ring[latency_pos] = ms;
+    latency_pos = (latency_pos + 1) % LATENCY_SAMPLES;
+    if (latency_n < LATENCY_SAMPLES) ++latency_n;
+}
+
+static int cmp_double_asc(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Hedge delay: configured percentile of recent latencies, else the fixed delay */
+static long long hedge_delay_ms(void) {
+    if (budget.hedge_delay_ms <= 0) return -1;
+    if (budget.hedge_percentile <= 0 || budget.hedge_percentile >= 100 || latency_n < LATENCY_MIN_SAMPLES)
+        return budget.hedge_delay_ms;
+    double sorted[LATENCY_SAMPLES];
+    memcpy(sorted, latency_ring, sizeof(double) * (size_t)latency_n);
+    qsort(sorted, (size_t)latency_n, sizeof(double), cmp_double_asc);
+    int idx = (latency_n * budget.hedge_percentile) / 100;
+    if (idx >= latency_n) idx = latency_n - 1;
+    return (long long)sorted[idx] + 1;
+}
+
+/* Prepare an easy handle for one POST; handles are reused so their connections stay alive.
+   timeout_ms bounds the whole transfer (<= 0: unbounded). */
+static void setup_request(CURL *curl, struct curl_slist *hdrs, const char *body, struct mem *resp, long timeout_ms) {
+    curl_easy_setopt(curl, CURLOPT_URL, ai_endpoint());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hdrs);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms > 0 ? timeout_ms : 0L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, budget.connect_timeout_ms > 0 ? (long)budget.connect_timeout_ms : 0L);
+}
+
+/* Primary and hedge handles, kept across calls for connection reuse */
+static CURLM *single_multi = NULL;
+static CURL *single_curl[2] = { NULL, NULL };
+
+/* Send the request, hedging with a second copy if the first is slow, and give up at the
+   deadline. Returns the assistant text (caller frees) or NULL; *hedged tells which won. */
+static char *call_openai_for_student(const char *student_json, bool *hedged) {
+    *hedged = false;
+    const char *key = getenv("OPENAI_API_KEY");
+    if (!key) return NULL;
+
+    if (!single_multi) single_multi = curl_multi_init();
+    for (int k = 0; k < 2; ++k) if (!single_curl[k]) single_curl[k] = curl_easy_init();
+    if (!single_multi || !single_curl[0] || !single_curl[1]) return NULL;
+
+    char *body = build_request_body(student_json);
+    if (!body) return NULL;
+    METRIC_TIMER_START(t0);
+    struct curl_slist *hdrs = build_headers(key);
+    struct mem resp[2] = { { NULL, 0 }, { NULL, 0 } };
+    bool started[2] = { false, false }, running[2] = { false, false };
+
+    const long long start = now_ms();
+    const long long deadline = budget.deadline_ms > 0 ? start + budget.deadline_ms : -1;
+    long long hd = hedge_delay_ms();
+    long long hedge_at = hd >= 0 ? start + hd : -1;
+    char *assistant_text = NULL;
+
+    for (int k = 0; !assistant_text; ) {
+        long long now = now_ms();
+        if (deadline >= 0 && now >= deadline) break;
+        /* launch primary first, then the hedge when its time comes */
+        if (!started[k] && (k == 0 || (hedge_at >= 0 && now >= hedge_at))) {
+            resp[k].ptr = malloc(1);
+            resp[k].len = 0;
+            if (!resp[k].ptr) break;
+            setup_request(single_curl[k], hdrs, body, &resp[k], deadline >= 0 ? (long)(deadline - now) : 0L);
+            curl_multi_add_handle(single_multi, single_curl[k]);
+            started[k] = running[k] = true;
+            if (k == 0) k = 1;
+        }
+        int still = 0;
+        curl_multi_perform(single_multi, &still);
+        CURLMsg *msg;
+        int left;
+        while ((msg = curl_multi_info_read(single_multi, &left)) && !assistant_text) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            int w = (msg->easy_handle == single_curl[1]) ? 1 : 0;
+            long status = 0;
+            curl_easy_getinfo(single_curl[w], CURLINFO_RESPONSE_CODE, &status);
+            CURLcode res = msg->data.result;
+            curl_multi_remove_handle(single_multi, single_curl[w]);
+            running[w] = false;
+            if (res == CURLE_OK && status < 400) {
+                assistant_text = extract_assistant_text(resp[w].ptr);
+                if (assistant_text) *hedged = (w == 1);
+            }
+        }
+        if (assistant_text) break;
+        if (!running[0] && !running[1]) {
+            if (started[1] || hedge_at < 0) break; /* every request failed */
+            hedge_at = now; /* primary failed early: use the hedge as an immediate retry */
+            continue;
+        }
+        long long wake = deadline >= 0 ? deadline : now + 100;
+        if (!started[1] && hedge_at >= 0 && hedge_at < wake) wake = hedge_at;
+        long long wait = wake - now_ms();
+        if (wait > 100) wait = 100;
+        if (wait < 1) wait = 1;
+        curl_multi_poll(single_multi, NULL, 0, (int)wait, NULL);
+    }
+
+    /* abandon the loser (or both, at the deadline) */
+    for (int k = 0; k < 2; ++k) {
+        if (running[k]) curl_multi_remove_handle(single_multi, single_curl[k]);
+        free(resp[k].ptr);
+    }
+    METRIC_TIMER_STOP(MET_AI_HTTP, t0);
+    if (assistant_text) record_latency((double)(now_ms() - start));
+    free(body);
+    curl_slist_free_all(hdrs);
     return assistant_text;
 }
 
@@ -171,50 +316,295 @@ static int parse_assistant_json(const char *txt, char *risk, int rlen, char *car
     return 1;
 }
 
-RiskLevel ai_predict_risk(const Student *s) {
-    char sj[512]; student_to_json(s, sj, sizeof(sj));
-    char *assistant = call_openai_for_student(sj);
-    if (!assistant) {
-        double avg = student_average(s);
-        if (avg < 45.0 || s->attendance < 50.0) return RISK_HIGH;
-        if (avg < 60.0 || s->attendance < 65.0) return RISK_MEDIUM;
-        return RISK_LOW;
-    }
-    char risk[BUF_SMALL]={0}, career[BUF_SMALL]={0}, explain[BUF_LARGE]={0};
-    int ok = parse_assistant_json(assistant, risk, sizeof(risk), career, sizeof(career), explain, sizeof(explain));
-    free(assistant);
-    if (!ok) return RISK_LOW;
+/* Local heuristic used whenever the remote model is unavailable */
+static RiskLevel fallback_risk(const Student *s) {
+    double avg = student_average(s);
+    if (avg < 45.0 || s->attendance < 50.0) return RISK_HIGH;
+    if (avg < 60.0 || s->attendance < 65.0) return RISK_MEDIUM;
+    return RISK_LOW;
+}
+
+static RiskLevel risk_from_text(char *risk) {
     for (char *p = risk; *p; ++p) *p = (char)toupper((unsigned char)*p);
     if (strcmp(risk, "HIGH") == 0) return RISK_HIGH;
     if (strcmp(risk, "MEDIUM") == 0) return RISK_MEDIUM;
     return RISK_LOW;
 }
 
-const char *ai_suggest_career(const Student *s) {
-    static char career_buf[BUF_SMALL];
-    career_buf[0] = '\0';
+const char *ai_risk_to_string(RiskLevel r) {
+    return (r == RISK_HIGH) ? "HIGH" : (r == RISK_MEDIUM ? "MEDIUM" : "LOW");
+}
+
+RiskLevel ai_local_risk(const Student *s) {
+    RiskLevel risk;
+    int career;
+    if (ai_model_predict(s, &risk, &career)) return risk;
+    return fallback_risk(s);
+}
+
+/* Local answer: the trained model when one is loaded, else the fixed heuristic */
+static void fallback_result(const Student *s, AiResult *out) {
+    int career;
+    if (ai_model_predict(s, &out->risk, &career)) {
+        out->source = AI_SOURCE_LOCAL_MODEL;
+        strncpy(out->career, ai_model_career_name(career), sizeof(out->career)-1);
+        snprintf(out->explanation, sizeof(out->explanation), "No AI available; local model prediction used.");
+        return;
+    }
+    out->source = AI_SOURCE_HEURISTIC;
+    out->risk = fallback_risk(s);
+    strncpy(out->career, "Unknown", sizeof(out->career)-1);
+    snprintf(out->explanation, sizeof(out->explanation), "No AI available; local fallback used.");
+}
+
+/* Fill out from the assistant's JSON answer */
+static void result_from_assistant(const char *assistant, AiResult *out) {
+    char risk[BUF_SMALL]={0};
+    parse_assistant_json(assistant, risk, sizeof(risk), out->career, sizeof(out->career), out->explanation, sizeof(out->explanation));
+    out->risk = risk_from_text(risk);
+    if (!out->career[0]) strncpy(out->career, "Unknown", sizeof(out->career)-1);
+    if (!out->explanation[0]) strncpy(out->explanation, "None", sizeof(out->explanation)-1);
+    out->source = AI_SOURCE_REMOTE;
+}
+
+const char *ai_source_to_string(AiSource src) {
+    switch (src) {
+        case AI_SOURCE_REMOTE: return "remote";
+        case AI_SOURCE_HEDGED: return "hedged";
+        case AI_SOURCE_CACHE: return "cache";
+        case AI_SOURCE_LOCAL_MODEL: return "local model";
+        default: return "heuristic";
+    }
+}
+
+static bool analyze_student(const Student *s, AiResult *out) {
+    long long start = now_ms();
     char sj[512]; student_to_json(s, sj, sizeof(sj));
-    char *assistant = call_openai_for_student(sj);
-    if (!assistant) { strncpy(career_buf, "Unknown", sizeof(career_buf)-1); return career_buf; }
-    char risk[BUF_SMALL]={0}, explain[BUF_LARGE]={0};
-    if (!parse_assistant_json(assistant, risk, sizeof(risk), career_buf, sizeof(career_buf), explain, sizeof(explain))) {
-        strncpy(career_buf, "Unknown", sizeof(career_buf)-1);
+    uint64_t key = ai_cache_key(sj, MODEL_NAME, PROMPT_VERSION);
+    if (ai_cache_lookup(key, out)) {
+        out->latency_ms = (double)(now_ms() - start);
+        return true;
+    }
+    bool hedged;
+    char *assistant = call_openai_for_student(sj, &hedged);
+    if (!assistant) {
+        fallback_result(s, out);
+        out->latency_ms = (double)(now_ms() - start);
+        return false;
     }
+    result_from_assistant(assistant, out);
     free(assistant);
+    ai_cache_store(key, s, out);
+    if (hedged) out->source = AI_SOURCE_HEDGED;
+    out->latency_ms = (double)(now_ms() - start);
+    return true;
+}
+
+bool ai_analyze(const Student *s, AiResult *out) {
+    if (!out) return false;
+    memset(out, 0, sizeof(*out));
+    if (!s) return false;
+    METRIC_TIMER_START(t0);
+    bool ok = analyze_student(s, out);
+    METRIC_TIMER_STOP(MET_AI_ANALYZE, t0);
+    return ok;
+}
+
+RiskLevel ai_predict_risk(const Student *s) {
+    AiResult r;
+    ai_analyze(s, &r);
+    return r.risk;
+}
+
+const char *ai_suggest_career(const Student *s) {
+    static char career_buf[BUF_SMALL];
+    AiResult r;
+    ai_analyze(s, &r);
+    strncpy(career_buf, r.career, sizeof(career_buf)-1);
+    career_buf[sizeof(career_buf)-1] = '\0';
     return career_buf;
 }
 
 void ai_explain(const Student *s, char *outbuf, int bufsize) {
     if (!outbuf || bufsize <= 0) return;
-    char sj[512]; student_to_json(s, sj, sizeof(sj));
-    char *assistant = call_openai_for_student(sj);
-    if (!assistant) {
-        snprintf(outbuf, bufsize, "No AI available; local fallback used.");
+    AiResult r;
+    if (!ai_analyze(s, &r)) {
+        snprintf(outbuf, bufsize, "%s", r.explanation);
         return;
     }
-    char risk[BUF_SMALL]={0}, career[BUF_SMALL]={0}, explain[BUF_LARGE]={0};
-    parse_assistant_json(assistant, risk, sizeof(risk), career, sizeof(career), explain, sizeof(explain));
-    free(assistant);
     snprintf(outbuf, bufsize, "Risk: %s. Career: %s. Explanation: %s",
-             risk[0] ? risk : "Unknown", career[0] ? career : "Unknown", explain[0] ? explain : "None");
+             ai_risk_to_string(r.risk), r.career, r.explanation);
+}
+
+/* ---- Batch analysis over curl multi ---- */
+
+#define BATCH_DEFAULT_CONCURRENCY 8
+#define BATCH_MAX_ATTEMPTS 3
+#define BATCH_RETRY_BASE_MS 1000
+
+typedef struct {
+    CURL *easy;       /* reused for every request this slot runs */
+    struct mem resp;
+    char *body;
+    int idx;          /* student index, -1 when idle */
+    int attempt;      /* 0 for the first try of idx */
+} BatchSlot;
+
+typedef struct {
+    int idx;
+    int attempt;
+    long long ready_ms;
+} BatchRetry;
+
+static void batch_finish(const Student *s, AiResult *r, AiBatchCallback cb, void *ctx, int *answered) {
+    if (AI_RESULT_FROM_MODEL(r)) ++*answered;
+    if (cb) cb(s, r, ctx);
+}
+
+static int analyze_batch(const Student *const *students, int n, const AiBatchOptions *opt, AiBatchCallback cb,
+                         void *ctx) {
+    int conc = (opt && opt->max_concurrency > 0) ? opt->max_concurrency : BATCH_DEFAULT_CONCURRENCY;
+    long long interval = (opt && opt->requests_per_minute > 0) ? 60000LL / opt->requests_per_minute : 0;
+    int answered = 0;
+    AiResult r;
+
+    /* Cached students are answered up front; the rest go to the network (or fallback) */
+    int *todo = (int *)malloc(sizeof(int) * (size_t)n);
+    if (!todo) return 0;
+    int ntodo = 0;
+    for (int i = 0; i < n; ++i) {
+        char sj[512]; student_to_json(students[i], sj, sizeof(sj));
+        memset(&r, 0, sizeof(r));
+        if (ai_cache_lookup(ai_cache_key(sj, MODEL_NAME, PROMPT_VERSION), &r)) {
+            batch_finish(students[i], &r, cb, ctx, &answered);
+        } else {
+            todo[ntodo++] = i;
+        }
+    }
+
+    const char *key = getenv("OPENAI_API_KEY");
+    CURLM *multi = key ? curl_multi_init() : NULL;
+    BatchSlot *slots = multi ? (BatchSlot *)calloc((size_t)conc, sizeof(BatchSlot)) : NULL;
+    /* a student is queued at most once; + 1 so an empty batch is not malloc(0) */
+    BatchRetry *retries = slots ? (BatchRetry *)malloc(sizeof(BatchRetry) * ((size_t)ntodo + 1)) : NULL;
+    if (!retries) {
+        for (int t = 0; t < ntodo; ++t) {
+            memset(&r, 0, sizeof(r));
+            fallback_result(students[todo[t]], &r);
+            batch_finish(students[todo[t]], &r, cb, ctx, &answered);
+        }
+        free(retries);
+        free(slots);
+        if (multi) curl_multi_cleanup(multi);
+        free(todo);
+        return answered;
+    }
+
+    /* One multi handle = one shared connection cache; cap connections at the concurrency */
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, (long)conc);
+    curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, (long)conc);
+    struct curl_slist *hdrs = build_headers(key);
+    for (int k = 0; k < conc; ++k) slots[k].idx = -1;
+
+    int next = 0, nretry = 0, active = 0;
+    long long next_start = 0;
+    while (next < ntodo || nretry > 0 || active > 0) {
+        long long now = now_ms();
+        /* start as many requests as free slots and pacing allow */
+        for (int k = 0; k < conc && now >= next_start; ++k) {
+            if (slots[k].idx >= 0) continue;
+            int idx = -1, attempt = 0;
+            for (int q = 0; q < nretry; ++q) {
+                if (retries[q].ready_ms <= now) {
+                    idx = retries[q].idx;
+                    attempt = retries[q].attempt;
+                    retries[q] = retries[--nretry];
+                    break;
+                }
+            }
+            if (idx < 0 && next < ntodo) idx = todo[next++];
+            if (idx < 0) break;
+            BatchSlot *sl = &slots[k];
+            if (!sl->easy) sl->easy = curl_easy_init();
+            char sj[512]; student_to_json(students[idx], sj, sizeof(sj));
+            sl->body = build_request_body(sj);
+            sl->resp.ptr = malloc(1);
+            sl->resp.len = 0;
+            if (!sl->easy || !sl->body || !sl->resp.ptr) {
+                free(sl->body); sl->body = NULL;
+                free(sl->resp.ptr); sl->resp.ptr = NULL;
+                memset(&r, 0, sizeof(r));
+                fallback_result(students[idx], &r);
+                batch_finish(students[idx], &r, cb, ctx, &answered);
+                continue;
+            }
+            sl->attempt = attempt;
+            sl->idx = idx;
+            setup_request(sl->easy, hdrs, sl->body, &sl->resp, (long)budget.deadline_ms);
+            curl_multi_add_handle(multi, sl->easy);
+            ++active;
+            next_start = now + interval;
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg *msg;
+        int left;
+        while ((msg = curl_multi_info_read(multi, &left))) {
+            if (msg->msg != CURLMSG_DONE) continue;
+            BatchSlot *sl = NULL;
+            for (int k = 0; k < conc; ++k)
+                if (slots[k].easy == msg->easy_handle && slots[k].idx >= 0) sl = &slots[k];
+            if (!sl) continue;
+            long status = 0;
+            curl_easy_getinfo(sl->easy, CURLINFO_RESPONSE_CODE, &status);
+            CURLcode res = msg->data.result;
+            curl_multi_remove_handle(multi, sl->easy);
+            --active;
+            const Student *st = students[sl->idx];
+            memset(&r, 0, sizeof(r));
+            char *assistant = (res == CURLE_OK && status < 400) ? extract_assistant_text(sl->resp.ptr) : NULL;
+            bool retryable = res != CURLE_OK || status == 429 || status >= 500;
+            if (assistant) {
+                result_from_assistant(assistant, &r);
+                free(assistant);
+                char sj[512]; student_to_json(st, sj, sizeof(sj));
+                ai_cache_store(ai_cache_key(sj, MODEL_NAME, PROMPT_VERSION), st, &r);
+                batch_finish(st, &r, cb, ctx, &answered);
+            } else if (retryable && sl->attempt + 1 < BATCH_MAX_ATTEMPTS) {
+                /* rate limited or transient failure: back off exponentially and requeue */
+                long long backoff = (long long)BATCH_RETRY_BASE_MS << sl->attempt;
+                retries[nretry].idx = sl->idx;
+                retries[nretry].attempt = sl->attempt + 1;
+                retries[nretry].ready_ms = now_ms() + backoff;
+                ++nretry;
+                /* a 429 applies to the whole key, so pause new starts as well */
+                if (status == 429) next_start = now_ms() + backoff;
+            } else {
+                fallback_result(st, &r);
+                batch_finish(st, &r, cb, ctx, &answered);
+            }
+            free(sl->body); sl->body = NULL;
+            free(sl->resp.ptr); sl->resp.ptr = NULL;
+            sl->idx = -1;
+        }
+        if (active > 0 || nretry > 0 || next < ntodo) curl_multi_poll(multi, NULL, 0, 50, NULL);
+    }
+
+    for (int k = 0; k < conc; ++k) if (slots[k].easy) curl_easy_cleanup(slots[k].easy);
+    curl_slist_free_all(hdrs);
+    curl_multi_cleanup(multi);
+    free(retries);
+    free(slots);
+    free(todo);
+    return answered;
+}
+
+int ai_analyze_batch(const Student *const *students, int n, const AiBatchOptions *opt, AiBatchCallback cb, void *ctx) {
+    if (!students || n <= 0) return 0;
+    METRIC_TIMER_START(t0);
+    int answered = analyze_batch(students, n, opt, cb, ctx);
+    METRIC_TIMER_STOP(MET_AI_BATCH, t0);
+    return answered;
 }
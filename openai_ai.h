@@ -2,12 +2,85 @@
 #define OPENAI_AI_H
 
 #include "student.h"
+#include <stdbool.h>
 
 typedef enum { RISK_LOW = 0, RISK_MEDIUM = 1, RISK_HIGH = 2 } RiskLevel;
 
-/* Same API as old ai.h so rest of project stays unchanged after include replacement */
+#define AI_CAREER_LEN 128
+#define AI_EXPLAIN_LEN 1024
+
+/* Which path produced an AiResult */
+typedef enum {
+    AI_SOURCE_REMOTE = 0,   /* primary request to the model */
+    AI_SOURCE_HEDGED,       /* hedged second request answered first */
+    AI_SOURCE_CACHE,        /* earlier remote answer from the AI result cache */
+    AI_SOURCE_LOCAL_MODEL,  /* local trained model (ai_model.h) */
+    AI_SOURCE_HEURISTIC     /* fixed average/attendance thresholds */
+} AiSource;
+
+/* Combined answer of one analysis request */
+typedef struct {
+    RiskLevel risk;
+    char career[AI_CAREER_LEN];
+    char explanation[AI_EXPLAIN_LEN];
+    AiSource source;
+    double latency_ms; /* wall time spent producing this result */
+} AiResult;
+
+/* True for answers that came from the remote model (now or via the cache) */
+#define AI_RESULT_FROM_MODEL(r) ((r)->source <= AI_SOURCE_CACHE)
+
+/* Latency budget applied to every remote request */
+typedef struct {
+    int deadline_ms;        /* hard bound per analysis; then the local fallback answers (<= 0: none) */
+    int connect_timeout_ms; /* TCP/TLS connect bound (<= 0: curl default) */
+    int hedge_delay_ms;     /* send a second identical request if no answer by then (<= 0: never) */
+    int hedge_percentile;   /* 1-99: use this percentile of recent latencies as the hedge delay once
+                               enough samples exist (hedge_delay_ms until then); 0: fixed delay */
+} AiLatencyBudget;
+
+/* Defaults: 8 s deadline, 3 s connect, hedge at p95 of recent latencies (2.5 s initially). */
+void ai_set_latency_budget(const AiLatencyBudget *b);
+void ai_get_latency_budget(AiLatencyBudget *b);
+
+/* "remote", "hedged", "cache", "local model", "heuristic" */
+const char *ai_source_to_string(AiSource src);
+
+/* One request returning risk, career and explanation together, bounded by the latency budget.
+   Repeat analyses of an unchanged record are answered from the AI result cache.
+   Always fills out (falling back locally, see out->source); returns true if the
+   remote model answered now or earlier. */
+bool ai_analyze(const Student *s, AiResult *out);
+
+/* "LOW" / "MEDIUM" / "HIGH" */
+const char *ai_risk_to_string(RiskLevel r);
+
+/* Risk from local knowledge only (the local model when loaded, else the heuristic); no network */
+RiskLevel ai_local_risk(const Student *s);
+
+/* Same API as old ai.h so rest of project stays unchanged after include replacement.
+   Each is a thin wrapper over ai_analyze (one request per call). */
 RiskLevel ai_predict_risk(const Student *s);
 const char *ai_suggest_career(const Student *s); /* pointer to internal static buffer */
 void ai_explain(const Student *s, char *outbuf, int bufsize);
 
+/* Override the Chat Completions URL (e.g. a local mock server); NULL/"" restores
+   the default. Without an override $SRMS_AI_URL is used if set, else OPENAI_URL. */
+void ai_set_endpoint(const char *url);
+
+/* Whole-roster analysis over one curl multi handle with reused connections */
+typedef struct {
+    int max_concurrency;     /* requests in flight at once (<= 0: 8) */
+    int requests_per_minute; /* minimum spacing between request starts (<= 0: unpaced) */
+} AiBatchOptions;
+
+/* Called once per student as soon as its result is known (cache hits first) */
+typedef void (*AiBatchCallback)(const Student *s, const AiResult *r, void *ctx);
+
+/* Analyze n students. HTTP 429/5xx and transport errors are retried with exponential
+   backoff (429 also pauses new starts); exhausted students get the local fallback.
+   Returns the number of results that came from the model or the cache. */
+int ai_analyze_batch(const Student *const *students, int n, const AiBatchOptions *opt,
+                     AiBatchCallback cb, void *ctx);
+
 #endif /* OPENAI_AI_H */
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include <stdlib.h>
+#include "pool.h"
+
+/* Slab header; objects follow it, aligned for any scalar type */
+typedef struct Slab {
+    struct Slab *next;
+    double align_pad;
+} Slab;
+
+void *pool_alloc(Pool *p) {
+    if (p->free_list) {
+        void *obj = p->free_list;
+        p->free_list = *(void **)obj;
+        return obj;
+    }
+    if (p->bump_left == 0) {
+        Slab *slab = (Slab *)malloc(sizeof(Slab) + p->obj_size * p->per_slab);
+        if (!slab) return NULL;
+        slab->next = (Slab *)p->slabs;
+        p->slabs = slab;
+        p->bump = (unsigned char *)(slab + 1);
+        p->bump_left = p->per_slab;
+    }
+    void *obj = p->bump;
+    p->bump += p->obj_size;
+    --p->bump_left;
+    return obj;
+}
+
+void pool_free(Pool *p, void *obj) {
+    if (!obj) return;
+    *(void **)obj = p->free_list;
+    p->free_list = obj;
+}
+
+void pool_release(Pool *p) {
+    Slab *slab = (Slab *)p->slabs;
+    while (slab) {
+        Slab *n = slab->next;
+        free(slab);
+        slab = n;
+    }
+    p->slabs = NULL;
+    p->free_list = NULL;
+    p->bump = NULL;
+    p->bump_left = 0;
+}
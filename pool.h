@@ -0,0 +1,29 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+/* Fixed-size object pool: objects are carved out of large contiguous slabs,
+   freed objects are recycled through an intrusive free list, and all slabs
+   are released together. */
+typedef struct Pool {
+    size_t obj_size;      /* rounded up to pointer alignment */
+    size_t per_slab;      /* objects per slab */
+    void *slabs;          /* singly linked list of slabs */
+    void *free_list;      /* recycled objects */
+    unsigned char *bump;  /* next never-used object in the newest slab */
+    size_t bump_left;
+} Pool;
+
+#define POOL_INIT(type, per_slab) { ((sizeof(type) + sizeof(void *) - 1) / sizeof(void *)) * sizeof(void *), (per_slab), NULL, NULL, NULL, 0 }
+
+/* Return an uninitialized object, or NULL when out of memory. */
+void *pool_alloc(Pool *p);
+
+/* Return obj (may be NULL) to the pool for reuse. */
+void pool_free(Pool *p, void *obj);
+
+/* Free every slab at once; all objects handed out become invalid. */
+void pool_release(Pool *p);
+
+#endif /* POOL_H */
@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "protocol.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#endif
+
+#define FRAME_HEADER 4
+
+static bool reserve(ProtoWriter *w, size_t extra) {
+    if (w->failed) return false;
+    if (w->len + extra <= w->cap) return true;
+    size_t ncap = w->cap ? w->cap : 256;
+    while (ncap < w->len + extra) ncap *= 2;
+    unsigned char *d = (unsigned char *)realloc(w->data, ncap);
+    if (!d) {
+        w->failed = true;
+        return false;
+    }
+    w->data = d;
+    w->cap = ncap;
+    return true;
+}
+
+void proto_begin(ProtoWriter *w) {
+    w->failed = false;
+    w->len = 0;
+    if (reserve(w, FRAME_HEADER)) w->len = FRAME_HEADER;
+}
+
+void proto_writer_free(ProtoWriter *w) {
+    free(w->data);
+    memset(w, 0, sizeof(*w));
+}
+
+/* --- encoding (byte by byte, so the wire format does not depend on the host) --- */
+
+static void put_le(ProtoWriter *w, uint64_t v, int bytes) {
+    if (!reserve(w, (size_t)bytes)) return;
+    for (int i = 0; i < bytes; ++i) w->data[w->len++] = (unsigned char)(v >> (8 * i));
+}
+
+void proto_put_u8(ProtoWriter *w, uint8_t v) {
+    put_le(w, v, 1);
+}
+
+void proto_put_u16(ProtoWriter *w, uint16_t v) {
+    put_le(w, v, 2);
+}
+
+void proto_put_u32(ProtoWriter *w, uint32_t v) {
+    put_le(w, v, 4);
+}
+
+void proto_put_u64(ProtoWriter *w, uint64_t v) {
+    put_le(w, v, 8);
+}
+
+void proto_put_i32(ProtoWriter *w, int32_t v) {
+    put_le(w, (uint32_t)v, 4);
+}
+
+void proto_put_f64(ProtoWriter *w, double v) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    put_le(w, bits, 8);
+}
+
+void proto_put_str(ProtoWriter *w, const char *s) {
+    size_t n = strlen(s);
+    if (n > 0xffff) n = 0xffff;
+    proto_put_u16(w, (uint16_t)n);
+    if (!reserve(w, n)) return;
+    memcpy(w->data + w->len, s, n);
+    w->len += n;
+}
+
+void proto_put_record(ProtoWriter *w, const Student *s) {
+    proto_put_i32(w, s->roll);
+    if (!reserve(w, NAME_LEN)) return;
+    memset(w->data + w->len, 0, NAME_LEN);
+    memcpy(w->data + w->len, s->name, strnlen(s->name, NAME_LEN - 1));
+    w->len += NAME_LEN;
+    for (int i = 0; i < NUM_SUBJECTS; ++i) proto_put_f64(w, s->marks[i]);
+    proto_put_f64(w, s->attendance);
+}
+
+void proto_put_stats(ProtoWriter *w, const DbStats *st) {
+    proto_put_u64(w, st->count);
+    proto_put_f64(w, st->mean);
+    proto_put_f64(w, st->min);
+    proto_put_f64(w, st->max);
+    proto_put_f64(w, st->stddev);
+    for (int b = 0; b < DB_STAT_BINS; ++b) proto_put_u64(w, st->hist[b]);
+}
+
+/* --- decoding --- */
+
+static uint64_t get_le(ProtoReader *r, int bytes) {
+    if (r->failed || r->len - r->pos < (size_t)bytes) {
+        r->failed = true;
+        return 0;
+    }
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= (uint64_t)r->data[r->pos++] << (8 * i);
+    return v;
+}
+
+uint8_t proto_get_u8(ProtoReader *r) {
+    return (uint8_t)get_le(r, 1);
+}
+
+uint16_t proto_get_u16(ProtoReader *r) {
+    return (uint16_t)get_le(r, 2);
+}
+
+uint32_t proto_get_u32(ProtoReader *r) {
+    return (uint32_t)get_le(r, 4);
+}
+
+uint64_t proto_get_u64(ProtoReader *r) {
+    return get_le(r, 8);
+}
+
+int32_t proto_get_i32(ProtoReader *r) {
+    return (int32_t)(uint32_t)get_le(r, 4);
+}
+
+double proto_get_f64(ProtoReader *r) {
+    uint64_t bits = get_le(r, 8);
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+bool proto_get_str(ProtoReader *r, char *buf, size_t cap) {
+    size_t n = proto_get_u16(r);
+    if (r->failed || n >= cap || r->len - r->pos < n) {
+        r->failed = true;
+        return false;
+    }
+    memcpy(buf, r->data + r->pos, n);
+    buf[n] = '\0';
+    r->pos += n;
+    return true;
+}
+
+bool proto_get_record(ProtoReader *r, Student *out) {
+    memset(out, 0, sizeof(*out));
+    out->roll = proto_get_i32(r);
+    if (r->failed || r->len - r->pos < NAME_LEN) {
+        r->failed = true;
+        return false;
+    }
+    memcpy(out->name, r->data + r->pos, NAME_LEN);
+    out->name[NAME_LEN - 1] = '\0';
+    r->pos += NAME_LEN;
+    for (int i = 0; i < NUM_SUBJECTS; ++i) out->marks[i] = proto_get_f64(r);
+    out->attendance = proto_get_f64(r);
+    out->next = NULL;
+    return !r->failed;
+}
+
+bool proto_get_stats(ProtoReader *r, DbStats *out) {
+    out->count = (size_t)proto_get_u64(r);
+    out->mean = proto_get_f64(r);
+    out->min = proto_get_f64(r);
+    out->max = proto_get_f64(r);
+    out->stddev = proto_get_f64(r);
+    for (int b = 0; b < DB_STAT_BINS; ++b) out->hist[b] = (size_t)proto_get_u64(r);
+    return !r->failed;
+}
+
+/* --- framing over a socket --- */
+
+#ifndef _WIN32
+
+static bool write_all(int fd, const unsigned char *p, size_t n) {
+    while (n > 0) {
+        ssize_t k = send(fd, p, n, MSG_NOSIGNAL);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        p += k;
+        n -= (size_t)k;
+    }
+    return true;
+}
+
+static bool read_all(int fd, unsigned char *p, size_t n) {
+    while (n > 0) {
+        ssize_t k = recv(fd, p, n, 0);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) return false;
+        p += k;
+        n -= (size_t)k;
+    }
+    return true;
+}
+
+bool proto_send(int fd, ProtoWriter *w) {
+    if (w->failed || w->len < FRAME_HEADER) return false;
+    uint32_t payload = (uint32_t)(w->len - FRAME_HEADER);
+    for (int i = 0; i < FRAME_HEADER; ++i) w->data[i] = (unsigned char)(payload >> (8 * i));
+    return write_all(fd, w->data, w->len);
+}
+
+bool proto_recv(int fd, ProtoWriter *buf, ProtoReader *r) {
+    proto_begin(buf);
+    if (buf->failed || !read_all(fd, buf->data, FRAME_HEADER)) return false;
+    uint32_t payload = 0;
+    for (int i = 0; i < FRAME_HEADER; ++i) payload |= (uint32_t)buf->data[i] << (8 * i);
+    if (payload == 0 || payload > PROTO_MAX_FRAME || !reserve(buf, payload)) return false;
+    if (!read_all(fd, buf->data + FRAME_HEADER, payload)) return false;
+    buf->len = FRAME_HEADER + payload;
+    r->data = buf->data + FRAME_HEADER;
+    r->len = payload;
+    r->pos = 0;
+    r->failed = false;
+    return true;
+}
+
+int proto_connect(const char *socket_path, const char *host, int port) {
+    if (socket_path) {
+        struct sockaddr_un addr;
+        if (strlen(socket_path) >= sizeof(addr.sun_path)) return -1;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, socket_path);
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host ? host : "127.0.0.1", service, &hints, &res) != 0) return -1;
+    int fd = -1;
+    for (struct addrinfo *a = res; a && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(res);
+    if (fd >= 0) {
+        /* requests are small and answered one at a time: do not wait to coalesce */
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+#else /* _WIN32: server mode is POSIX-only */
+
+bool proto_send(int fd, ProtoWriter *w) {
+    (void)fd;
+    (void)w;
+    return false;
+}
+
+bool proto_recv(int fd, ProtoWriter *buf, ProtoReader *r) {
+    (void)fd;
+    (void)buf;
+    (void)r;
+    return false;
+}
+
+int proto_connect(const char *socket_path, const char *host, int port) {
+    (void)socket_path;
+    (void)host;
+    (void)port;
+    return -1;
+}
+
+#endif
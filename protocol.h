@@ -0,0 +1,98 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include "student.h"
+#include "database.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Binary request protocol of the server mode (server.c) and its clients.
+   Every message is a frame: a 4-byte little-endian payload length, then the payload.
+   A request payload starts with a one-byte ProtoOp, a response with a one-byte
+   ProtoStatus. Integers are little-endian, doubles travel as their IEEE-754 bits in
+   a little-endian u64, strings are a u16 length and the bytes. A record is
+   i32 roll, NAME_LEN name bytes, NUM_SUBJECTS marks, attendance. */
+
+#define PROTO_MAX_FRAME (1u << 20)
+#define PROTO_MAX_RECORDS 4096 /* records in one response; larger requests are capped */
+#define PROTO_RECORD_BYTES (4 + NAME_LEN + 8 * (NUM_SUBJECTS + 1))
+
+typedef enum {
+    OP_PING = 1, /* -> (nothing) */
+    OP_COUNT,    /* -> u64 count */
+    OP_GET,      /* i32 roll -> record */
+    OP_FIND,     /* u8 NameMatch, u32 max, str name -> u32 total, u32 n, n records */
+    OP_LIST,     /* i32 lo, i32 hi, i32 after_roll, u8 after, u32 max -> u32 n, n records */
+    OP_TOP,      /* u8 key, u8 highest, u32 k -> u32 n, n records */
+    OP_RANK,     /* i32 roll, u8 key -> u32 rank, u64 total */
+    OP_STATS,    /* u8 field -> stats (see proto_put_stats) */
+    OP_QUERY,    /* u32 max, str query -> u64 total, u32 n, n records (REJECTED: str error) */
+    OP_ADD,      /* record */
+    OP_UPDATE,   /* record; an empty name keeps the current one */
+    OP_DELETE,   /* i32 roll */
+    OP_DUMP      /* -> several responses of u32 n, n records in roll order; n = 0 ends */
+} ProtoOp;
+
+typedef enum {
+    PROTO_OK = 0,
+    PROTO_NOT_FOUND,   /* no such roll (GET, RANK, UPDATE, DELETE) */
+    PROTO_REJECTED,    /* ADD of an existing roll, or values outside 0-100 */
+    PROTO_BAD_REQUEST, /* malformed payload or unknown opcode; the server closes the connection */
+    PROTO_FAILED       /* out of memory or I/O error */
+} ProtoStatus;
+
+/* Growing output buffer; the first 4 bytes are reserved for the frame length. */
+typedef struct {
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+    bool failed; /* an allocation failed; the frame must not be sent */
+} ProtoWriter;
+
+/* Cursor over a received payload; any read past the end sets failed. */
+typedef struct {
+    const unsigned char *data;
+    size_t len;
+    size_t pos;
+    bool failed;
+} ProtoReader;
+
+/* Start a new frame in w (keeps the allocation). */
+void proto_begin(ProtoWriter *w);
+void proto_writer_free(ProtoWriter *w);
+
+void proto_put_u8(ProtoWriter *w, uint8_t v);
+void proto_put_u16(ProtoWriter *w, uint16_t v);
+void proto_put_u32(ProtoWriter *w, uint32_t v);
+void proto_put_u64(ProtoWriter *w, uint64_t v);
+void proto_put_i32(ProtoWriter *w, int32_t v);
+void proto_put_f64(ProtoWriter *w, double v);
+void proto_put_str(ProtoWriter *w, const char *s);
+void proto_put_record(ProtoWriter *w, const Student *s);
+void proto_put_stats(ProtoWriter *w, const DbStats *st);
+
+uint8_t proto_get_u8(ProtoReader *r);
+uint16_t proto_get_u16(ProtoReader *r);
+uint32_t proto_get_u32(ProtoReader *r);
+uint64_t proto_get_u64(ProtoReader *r);
+int32_t proto_get_i32(ProtoReader *r);
+double proto_get_f64(ProtoReader *r);
+/* Copies the string into buf (NUL-terminated); fails if it does not fit. */
+bool proto_get_str(ProtoReader *r, char *buf, size_t cap);
+/* out->next is NULL; the name is always NUL-terminated. */
+bool proto_get_record(ProtoReader *r, Student *out);
+bool proto_get_stats(ProtoReader *r, DbStats *out);
+
+/* Send the frame built in w with one write. */
+bool proto_send(int fd, ProtoWriter *w);
+
+/* Receive one frame into buf (payload at buf->data + 4, length buf->len - 4) and
+   point r at its payload. Returns false on EOF, I/O error or an oversized frame. */
+bool proto_recv(int fd, ProtoWriter *buf, ProtoReader *r);
+
+/* Connect to the server at a Unix socket path, or at host:port over TCP when
+   socket_path is NULL. Returns the socket or -1. */
+int proto_connect(const char *socket_path, const char *host, int port);
+
+#endif /* PROTOCOL_H */
@@ -0,0 +1,272 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include "query.h"
+#include "columns.h"
+#include "database.h"
+#include "metrics.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static bool term_test(double x, QueryOp op, double v) {
+    switch (op) {
+        case QUERY_LT: return x < v;
+        case QUERY_LE: return x <= v;
+        case QUERY_GT: return x > v;
+        case QUERY_GE: return x >= v;
+        default: return x == v;
+    }
+}
+
+/* Compare up to 64 consecutive values against v; bit j is set when x[j] matches */
+static uint64_t kernel_compare(const double *x, size_t cnt, QueryOp op, double v) {
+    uint64_t bits = 0;
+    size_t j = 0;
+#if defined(__AVX__)
+    const __m256d vv = _mm256_set1_pd(v);
+#define CMP_LOOP(PRED) \
+    for (; j + 4 <= cnt; j += 4) \
+        bits |= (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(x + j), vv, PRED)) << j
+    switch (op) {
+        case QUERY_LT: CMP_LOOP(_CMP_LT_OQ); break;
+        case QUERY_LE: CMP_LOOP(_CMP_LE_OQ); break;
+        case QUERY_GT: CMP_LOOP(_CMP_GT_OQ); break;
+        case QUERY_GE: CMP_LOOP(_CMP_GE_OQ); break;
+        default: CMP_LOOP(_CMP_EQ_OQ); break;
+    }
+#undef CMP_LOOP
+#elif defined(__SSE2__)
+    const __m128d vv = _mm_set1_pd(v);
+#define CMP_LOOP(CMP) \
+    for (; j + 2 <= cnt; j += 2) \
+        bits |= (uint64_t)_mm_movemask_pd(CMP(_mm_loadu_pd(x + j), vv)) << j
+    switch (op) {
+        case QUERY_LT: CMP_LOOP(_mm_cmplt_pd); break;
+        case QUERY_LE: CMP_LOOP(_mm_cmple_pd); break;
+        case QUERY_GT: CMP_LOOP(_mm_cmpgt_pd); break;
+        case QUERY_GE: CMP_LOOP(_mm_cmpge_pd); break;
+        default: CMP_LOOP(_mm_cmpeq_pd); break;
+    }
+#undef CMP_LOOP
+#endif
+    for (; j < cnt; ++j)
+        if (term_test(x[j], op, v)) bits |= (uint64_t)1 << j;
+    return bits;
+}
+
+/* Bits of the rows base..base+cnt-1 that satisfy a term, by scanning columns */
+static uint64_t scan_block(const QueryTerm *t, size_t base, size_t cnt) {
+    if (t->field <= QUERY_FIELD_ATTENDANCE) return kernel_compare(col_data(t->field) + base, cnt, t->op, t->value);
+    double tmp[64];
+    for (size_t j = 0; j < cnt; ++j) tmp[j] = 0.0;
+    if (t->field == QUERY_FIELD_AVERAGE) {
+        /* same order of additions as student_average */
+        for (int i = 0; i < NUM_SUBJECTS; ++i) {
+            const double *x = col_data(i) + base;
+            for (size_t j = 0; j < cnt; ++j) tmp[j] += x[j];
+        }
+        for (size_t j = 0; j < cnt; ++j) tmp[j] /= NUM_SUBJECTS;
+    } else {
+        for (int i = 0; i < NUM_SUBJECTS; ++i) {
+            const double *x = col_data(i) + base;
+            for (size_t j = 0; j < cnt; ++j) tmp[j] += x[j] < t->below ? 1.0 : 0.0;
+        }
+    }
+    return kernel_compare(tmp, cnt, t->op, t->value);
+}
+
+typedef enum { BUCKET_NONE, BUCKET_SOME, BUCKET_ALL } BucketMatch;
+
+/* Whether none, some or all values of a bucket can satisfy the term */
+static BucketMatch bucket_match(int b, QueryOp op, double v) {
+    double lo = b == 0 ? -INFINITY : b * COL_BUCKET_WIDTH;
+    double hi = b == COL_BUCKETS - 1 ? INFINITY : (b + 1) * COL_BUCKET_WIDTH; /* exclusive */
+    bool none, all;
+    switch (op) {
+        case QUERY_LT: none = lo >= v; all = hi <= v; break;
+        case QUERY_LE: none = lo > v; all = hi <= v; break;
+        case QUERY_GT: none = hi <= v; all = lo > v; break;
+        case QUERY_GE: none = hi <= v; all = lo >= v; break;
+        default: none = v < lo || v >= hi; all = false; break;
+    }
+    if (none) return BUCKET_NONE;
+    /* the open-ended buckets may hold anything (NaN, negatives), so always check them */
+    if (all && b != 0 && b != COL_BUCKETS - 1) return BUCKET_ALL;
+    return BUCKET_SOME;
+}
+
+/* res &= rows satisfying t, using the bucket bitmaps of its column */
+static bool apply_indexed(const QueryTerm *t, uint64_t *res, size_t words) {
+    uint64_t *acc = (uint64_t *)calloc(words, sizeof(uint64_t));
+    if (!acc) return false;
+    const double *x = col_data(t->field);
+    for (int b = 0; b < COL_BUCKETS; ++b) {
+        BucketMatch m = bucket_match(b, t->op, t->value);
+        if (m == BUCKET_NONE) continue;
+        const uint64_t *bm = col_bucket_bitmap(t->field, b);
+        for (size_t w = 0; w < words; ++w) {
+            uint64_t cand = bm[w] & res[w];
+            if (m == BUCKET_ALL) {
+                acc[w] |= cand;
+                continue;
+            }
+            for (; cand; cand &= cand - 1) {
+                int j = __builtin_ctzll(cand);
+                if (term_test(x[w * 64 + (size_t)j], t->op, t->value)) acc[w] |= (uint64_t)1 << j;
+            }
+        }
+    }
+    memcpy(res, acc, words * sizeof(uint64_t));
+    free(acc);
+    return true;
+}
+
+static bool query_valid(const Query *q) {
+    if (!q || q->count < 0 || q->count > QUERY_MAX_TERMS) return false;
+    for (int i = 0; i < q->count; ++i) {
+        const QueryTerm *t = &q->terms[i];
+        if (t->field < 0 || t->field > QUERY_FIELD_BELOW_COUNT) return false;
+        if (t->op < QUERY_LT || t->op > QUERY_EQ) return false;
+    }
+    return true;
+}
+
+static size_t run_query(const Query *q, Student *out, size_t max) {
+    size_t n = col_count();
+    if (n == 0) return 0;
+    size_t words = (n + 63) / 64;
+    uint64_t *res = (uint64_t *)malloc(words * sizeof(uint64_t));
+    if (!res) return (size_t)-1;
+    memset(res, 0xff, words * sizeof(uint64_t));
+    if (n % 64) res[words - 1] = ((uint64_t)1 << (n % 64)) - 1;
+
+    /* indexed terms first: they only touch the bitmaps and the rows near a bucket edge */
+    bool indexed = col_buckets_enabled();
+    for (int i = 0; i < q->count; ++i) {
+        const QueryTerm *t = &q->terms[i];
+        if (!indexed || t->field > QUERY_FIELD_ATTENDANCE) continue;
+        if (!apply_indexed(t, res, words)) {
+            free(res);
+            return (size_t)-1;
+        }
+    }
+    for (int i = 0; i < q->count; ++i) {
+        const QueryTerm *t = &q->terms[i];
+        if (indexed && t->field <= QUERY_FIELD_ATTENDANCE) continue;
+        for (size_t w = 0; w < words; ++w) {
+            if (!res[w]) continue;
+            size_t base = w * 64, cnt = n - base < 64 ? n - base : 64;
+            res[w] &= scan_block(t, base, cnt);
+        }
+    }
+
+    const int *rolls = col_rolls();
+    size_t total = 0;
+    for (size_t w = 0; w < words; ++w) {
+        for (uint64_t m = res[w]; m; m &= m - 1) {
+            if (total < max) {
+                out[total] = *db_search_by_roll(rolls[w * 64 + (size_t)__builtin_ctzll(m)]);
+                out[total].next = NULL;
+            }
+            ++total;
+        }
+    }
+    free(res);
+    METRIC_ADD(MET_RECORDS_SCANNED, n);
+    return total;
+}
+
+size_t query_run(const Query *q, Student *out, size_t max) {
+    if (!query_valid(q) || (max > 0 && !out)) return (size_t)-1;
+    METRIC_TIMER_START(t0);
+    size_t total = run_query(q, out, max);
+    METRIC_TIMER_STOP(MET_QUERY, t0);
+    return total;
+}
+
+/* --- parser --- */
+
+static const struct {
+    const char *name;
+    int field;
+} query_fields[] = {
+    {"math", 0}, {"mathematics", 0}, {"physics", 1}, {"chemistry", 2},
+    {"cs", 3}, {"computerscience", 3}, {"english", 4},
+    {"attendance", QUERY_FIELD_ATTENDANCE}, {"avg", QUERY_FIELD_AVERAGE}, {"average", QUERY_FIELD_AVERAGE},
+    {"below", QUERY_FIELD_BELOW_COUNT},
+};
+
+static const char *skip_space(const char *p) {
+    while (isspace((unsigned char)*p)) ++p;
+    return p;
+}
+
+static bool parse_number(const char **p, double *out) {
+    char *end;
+    *out = strtod(*p, &end);
+    if (end == *p) return false;
+    *p = end;
+    return true;
+}
+
+static bool parse_fail(char *err, size_t errlen, const char *msg, const char *at) {
+    if (err && errlen) snprintf(err, errlen, "%s at \"%.20s\"", msg, at);
+    return false;
+}
+
+bool query_parse(const char *text, Query *q, char *err, size_t errlen) {
+    if (!text || !q) return false;
+    memset(q, 0, sizeof(*q));
+    const char *p = skip_space(text);
+    if (!*p) return true;
+    for (;;) {
+        if (q->count == QUERY_MAX_TERMS) return parse_fail(err, errlen, "too many terms", p);
+        QueryTerm *t = &q->terms[q->count];
+
+        char word[32];
+        size_t len = 0;
+        while (isalpha((unsigned char)p[len])) {
+            if (len + 1 < sizeof(word)) word[len] = (char)tolower((unsigned char)p[len]);
+            ++len;
+        }
+        word[len < sizeof(word) ? len : sizeof(word) - 1] = '\0';
+        t->field = -1;
+        for (size_t i = 0; len < sizeof(word) && i < sizeof(query_fields) / sizeof(query_fields[0]); ++i)
+            if (strcmp(word, query_fields[i].name) == 0) t->field = query_fields[i].field;
+        if (t->field < 0) return parse_fail(err, errlen, "unknown field", p);
+        p = skip_space(p + len);
+        if (t->field == QUERY_FIELD_BELOW_COUNT) {
+            if (*p != '(') return parse_fail(err, errlen, "expected '(' after below", p);
+            p = skip_space(p + 1);
+            if (!parse_number(&p, &t->below)) return parse_fail(err, errlen, "expected marks threshold", p);
+            p = skip_space(p);
+            if (*p != ')') return parse_fail(err, errlen, "expected ')'", p);
+            p = skip_space(p + 1);
+        }
+
+        if (p[0] == '<' && p[1] == '=') { t->op = QUERY_LE; p += 2; }
+        else if (p[0] == '>' && p[1] == '=') { t->op = QUERY_GE; p += 2; }
+        else if (p[0] == '=' && p[1] == '=') { t->op = QUERY_EQ; p += 2; }
+        else if (p[0] == '<') { t->op = QUERY_LT; p += 1; }
+        else if (p[0] == '>') { t->op = QUERY_GT; p += 1; }
+        else if (p[0] == '=') { t->op = QUERY_EQ; p += 1; }
+        else return parse_fail(err, errlen, "expected comparison operator", p);
+        p = skip_space(p);
+        if (!parse_number(&p, &t->value)) return parse_fail(err, errlen, "expected number", p);
+        ++q->count;
+
+        p = skip_space(p);
+        if (!*p) return true;
+        if (p[0] == '&' && p[1] == '&') p += 2;
+        else if (tolower((unsigned char)p[0]) == 'a' && tolower((unsigned char)p[1]) == 'n' &&
+                 tolower((unsigned char)p[2]) == 'd' && !isalnum((unsigned char)p[3])) p += 3;
+        else return parse_fail(err, errlen, "expected 'and'", p);
+        p = skip_space(p);
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+#include "student.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Filter queries: an AND of comparisons over marks, attendance, average and
+   below-threshold counts, evaluated as bitmaps over the columnar store
+   (columns.h). Subject and attendance terms use the bucketed bitmap index when
+   it is enabled; the rest are vectorized column scans that skip 64-row blocks
+   already ruled out. */
+
+#define QUERY_MAX_TERMS 8
+
+/* Fields: 0..NUM_SUBJECTS-1 are the subjects in student.h order */
+#define QUERY_FIELD_ATTENDANCE NUM_SUBJECTS
+#define QUERY_FIELD_AVERAGE (NUM_SUBJECTS + 1)
+#define QUERY_FIELD_BELOW_COUNT (NUM_SUBJECTS + 2) /* subjects with marks < below */
+
+typedef enum {
+    QUERY_LT,
+    QUERY_LE,
+    QUERY_GT,
+    QUERY_GE,
+    QUERY_EQ
+} QueryOp;
+
+typedef struct {
+    int field;
+    QueryOp op;
+    double value;
+    double below; /* per-subject threshold, QUERY_FIELD_BELOW_COUNT only */
+} QueryTerm;
+
+typedef struct {
+    QueryTerm terms[QUERY_MAX_TERMS];
+    int count; /* 0 matches every student */
+} Query;
+
+/* Parse text such as "attendance < 65 and below(40) > 2". Fields: math, physics,
+   chemistry, cs, english, attendance, avg, below(<marks>); operators < <= > >= =;
+   terms joined by "and" or "&&". On failure returns false and describes the
+   problem in err (if non-NULL). */
+bool query_parse(const char *text, Query *q, char *err, size_t errlen);
+
+/* Evaluate q and copy up to max matching students into out (storage order, next
+   set to NULL); out may be NULL when max is 0. Returns the total number of matches,
+   or (size_t)-1 for an invalid query or allocation failure. */
+size_t query_run(const Query *q, Student *out, size_t max);
+
+#endif /* QUERY_H */
@@ -0,0 +1,288 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "record.h"
+#include "pool.h"
+
+#define RECORDS_PER_SLAB 4096 /* 128 KiB slabs */
+#define VALUE_COUNT (NUM_SUBJECTS + 1) /* marks, then attendance */
+#define NAME_TABLE_MIN_CAP 64
+
+_Static_assert(sizeof(Record) == 32, "Record should stay two per cache line");
+
+static Pool record_pool = POOL_INIT(Record, RECORDS_PER_SLAB);
+static size_t records_live = 0;
+
+/* --- name arena ---
+   Names are stored back to back (with their NUL) in one growing buffer. Each distinct
+   name has an entry with a reference count; an open-addressing table on the name
+   finds the entry to share. A released name's bytes go on a free list for its
+   length and are reused by the next name of that length. */
+
+typedef struct {
+    uint32_t off;  /* in name_bytes; next free entry + 1 while unused */
+    uint32_t refs; /* 0 marks an unused entry */
+    uint32_t hash;
+    uint32_t len;
+} NameEntry;
+
+static char *name_bytes = NULL;
+static size_t name_used = 0, name_cap = 0;
+static uint32_t hole_head[NAME_LEN]; /* per length: freed range offset + 1, chained through the range */
+static NameEntry *names = NULL;
+static uint32_t names_n = 0, names_cap = 0;
+static uint32_t name_free = 0;  /* unused entry + 1, 0 when none */
+static uint32_t *name_table = NULL; /* entry + 1, 0 marks an empty slot */
+static size_t name_table_cap = 0;   /* always a power of two */
+static size_t name_count = 0;       /* distinct names held */
+
+/* FNV-1a */
+static uint32_t name_hash(const char *s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; ++i) h = (h ^ (unsigned char)s[i]) * 16777619u;
+    return h;
+}
+
+static void name_table_place(uint32_t *tab, size_t cap, uint32_t e) {
+    size_t mask = cap - 1;
+    size_t i = names[e].hash & mask;
+    while (tab[i]) i = (i + 1) & mask;
+    tab[i] = e + 1;
+}
+
+/* Keep the load factor <= 0.5 for one more name */
+static bool name_table_reserve(void) {
+    if ((name_count + 1) * 2 <= name_table_cap) return true;
+    size_t ncap = name_table_cap ? name_table_cap * 2 : NAME_TABLE_MIN_CAP;
+    uint32_t *ntab = (uint32_t *)calloc(ncap, sizeof(uint32_t));
+    if (!ntab) return false;
+    for (size_t i = 0; i < name_table_cap; ++i)
+        if (name_table[i]) name_table_place(ntab, ncap, name_table[i] - 1);
+    free(name_table);
+    name_table = ntab;
+    name_table_cap = ncap;
+    return true;
+}
+
+/* Room for len bytes plus NUL: a freed range of the same length, else the end */
+static bool name_space(size_t len, uint32_t *off) {
+    if (len + 1 >= sizeof(uint32_t) && hole_head[len]) {
+        *off = hole_head[len] - 1;
+        memcpy(&hole_head[len], name_bytes + *off, sizeof(uint32_t));
+        return true;
+    }
+    if (name_used + len + 1 > name_cap) {
+        size_t ncap = name_cap ? name_cap * 2 : 4096;
+        while (ncap < name_used + len + 1) ncap *= 2;
+        if (ncap > UINT32_MAX) return false;
+        char *nb = (char *)realloc(name_bytes, ncap);
+        if (!nb) return false;
+        name_bytes = nb;
+        name_cap = ncap;
+    }
+    *off = (uint32_t)name_used;
+    name_used += len + 1;
+    return true;
+}
+
+/* Handle of name, shared if already present; UINT32_MAX when out of memory */
+static uint32_t name_intern(const char *name) {
+    size_t len = strnlen(name, NAME_LEN - 1);
+    uint32_t h = name_hash(name, len);
+    if (name_table_cap) {
+        size_t mask = name_table_cap - 1;
+        for (size_t i = h & mask; name_table[i]; i = (i + 1) & mask) {
+            NameEntry *e = &names[name_table[i] - 1];
+            if (e->hash == h && e->len == len && memcmp(name_bytes + e->off, name, len) == 0) {
+                ++e->refs;
+                return name_table[i] - 1;
+            }
+        }
+    }
+    if (!name_table_reserve()) return UINT32_MAX;
+    if (!name_free && names_n == names_cap) {
+        uint32_t ncap = names_cap ? names_cap * 2 : 1024;
+        NameEntry *ne = (NameEntry *)realloc(names, ncap * sizeof(NameEntry));
+        if (!ne) return UINT32_MAX;
+        names = ne;
+        names_cap = ncap;
+    }
+    uint32_t off;
+    if (!name_space(len, &off)) return UINT32_MAX;
+    uint32_t e;
+    if (name_free) {
+        e = name_free - 1;
+        name_free = names[e].off;
+    } else {
+        e = names_n++;
+    }
+    memcpy(name_bytes + off, name, len);
+    name_bytes[off + len] = '\0';
+    names[e] = (NameEntry){ off, 1, h, (uint32_t)len };
+    name_table_place(name_table, name_table_cap, e);
+    ++name_count;
+    return e;
+}
+
+/* Drop one reference; the last one frees the entry and its bytes */
+static void name_release(uint32_t e) {
+    NameEntry *ent = &names[e];
+    if (--ent->refs > 0) return;
+    /* remove from the table, shifting back later entries of the probe run */
+    size_t mask = name_table_cap - 1;
+    size_t hole = ent->hash & mask;
+    while (name_table[hole] != e + 1) hole = (hole + 1) & mask;
+    for (size_t i = (hole + 1) & mask; name_table[i]; i = (i + 1) & mask) {
+        size_t home = names[name_table[i] - 1].hash & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            name_table[hole] = name_table[i];
+            hole = i;
+        }
+    }
+    name_table[hole] = 0;
+    --name_count;
+    /* names shorter than the link are left in place */
+    if (ent->len + 1 >= sizeof(uint32_t)) {
+        memcpy(name_bytes + ent->off, &hole_head[ent->len], sizeof(uint32_t));
+        hole_head[ent->len] = ent->off + 1;
+    }
+    ent->off = name_free;
+    name_free = e + 1;
+}
+
+/* --- exact values of records with a mark or attendance off the 0.01 grid --- */
+
+typedef union {
+    double v[VALUE_COUNT];
+    uint32_t next_free; /* unused slot + 1 */
+} ExactSlot;
+
+static ExactSlot *exact = NULL;
+static uint32_t exact_n = 0, exact_cap = 0;
+static uint32_t exact_free = 0;
+
+static uint32_t exact_alloc(void) {
+    if (exact_free) {
+        uint32_t i = exact_free - 1;
+        exact_free = exact[i].next_free;
+        return i;
+    }
+    if (exact_n == exact_cap) {
+        uint32_t ncap = exact_cap ? exact_cap * 2 : 64;
+        ExactSlot *ne = (ExactSlot *)realloc(exact, ncap * sizeof(ExactSlot));
+        if (!ne) return UINT32_MAX;
+        exact = ne;
+        exact_cap = ncap;
+    }
+    return exact_n++;
+}
+
+static void exact_release(uint32_t i) {
+    exact[i].next_free = exact_free;
+    exact_free = i + 1;
+}
+
+/* --- records --- */
+
+unsigned record_fixed(double v) {
+    if (!(v >= 0.0 && v <= 100.0) || signbit(v)) return RECORD_FIXED_ESCAPE;
+    double q = floor(v * 100.0 + 0.5);
+    return q / 100.0 == v ? (unsigned)q : RECORD_FIXED_ESCAPE;
+}
+
+/* Fill r's values and name from s; r->name and r->exact are released by the caller */
+static bool fill(Record *r, const Student *s, uint32_t old_exact) {
+    unsigned f[VALUE_COUNT];
+    bool escaped = false;
+    for (int i = 0; i < VALUE_COUNT; ++i) {
+        f[i] = record_fixed(i < NUM_SUBJECTS ? s->marks[i] : s->attendance);
+        escaped |= f[i] == RECORD_FIXED_ESCAPE;
+    }
+    uint32_t slot = 0;
+    if (escaped) {
+        uint32_t x = old_exact ? old_exact - 1 : exact_alloc();
+        if (x == UINT32_MAX) return false;
+        slot = x + 1;
+    }
+    uint32_t name = name_intern(s->name);
+    if (name == UINT32_MAX) {
+        if (slot && !old_exact) exact_release(slot - 1);
+        return false;
+    }
+    if (slot) {
+        memcpy(exact[slot - 1].v, s->marks, sizeof(s->marks));
+        exact[slot - 1].v[NUM_SUBJECTS] = s->attendance;
+    }
+    r->roll = s->roll;
+    for (int i = 0; i < NUM_SUBJECTS; ++i) r->marks[i] = (uint16_t)f[i];
+    r->attendance = (uint16_t)f[NUM_SUBJECTS];
+    r->name = name;
+    r->exact = slot;
+    return true;
+}
+
+Record *record_create(const Student *s) {
+    Record *r = (Record *)pool_alloc(&record_pool);
+    if (!r) return NULL;
+    if (!fill(r, s, 0)) {
+        pool_free(&record_pool, r);
+        return NULL;
+    }
+    r->next = NULL;
+    ++records_live;
+    return r;
+}
+
+bool record_store(Record *r, const Student *s) {
+    uint32_t old_name = r->name, old_exact = r->exact;
+    if (!fill(r, s, old_exact)) return false;
+    /* the new name holds its own reference, so releasing the old one is safe */
+    name_release(old_name);
+    if (old_exact && !r->exact) exact_release(old_exact - 1);
+    return true;
+}
+
+void record_free(Record *r) {
+    if (!r) return;
+    name_release(r->name);
+    if (r->exact) exact_release(r->exact - 1);
+    pool_free(&record_pool, r);
+    --records_live;
+}
+
+void record_release_all(void) {
+    pool_release(&record_pool);
+    records_live = 0;
+    free(name_bytes);
+    free(names);
+    free(name_table);
+    free(exact);
+    name_bytes = NULL;
+    names = NULL;
+    name_table = NULL;
+    exact = NULL;
+    name_used = name_cap = name_table_cap = name_count = 0;
+    names_n = names_cap = name_free = 0;
+    exact_n = exact_cap = exact_free = 0;
+    memset(hole_head, 0, sizeof(hole_head));
+}
+
+void record_load(const Record *r, Student *out) {
+    const NameEntry *e = &names[r->name];
+    memcpy(out->name, name_bytes + e->off, e->len + 1);
+    out->roll = r->roll;
+    const double *x = r->exact ? exact[r->exact - 1].v : NULL;
+    for (int i = 0; i < NUM_SUBJECTS; ++i)
+        out->marks[i] = r->marks[i] == RECORD_FIXED_ESCAPE ? x[i] : r->marks[i] / 100.0;
+    out->attendance = r->attendance == RECORD_FIXED_ESCAPE ? x[NUM_SUBJECTS] : r->attendance / 100.0;
+    out->next = NULL;
+}
+
+const char *record_name(const Record *r) {
+    return name_bytes + names[r->name].off;
+}
+
+size_t record_memory(void) {
+    return records_live * sizeof(Record) + name_cap + (size_t)names_cap * sizeof(NameEntry) +
+           name_table_cap * sizeof(uint32_t) + (size_t)exact_cap * sizeof(ExactSlot);
+}
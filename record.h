@@ -0,0 +1,55 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include "student.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Compact resident form of a student, kept by database.c instead of a full Student
+   (160 bytes, most of it the fixed name buffer). Everything lookups and scans touch
+   fits in 32 bytes, two records per cache line:
+     marks and attendance in hundredths (0..10000). A value that is not an exact
+       multiple of 0.01 reads RECORD_FIXED_ESCAPE and the record's exact values are
+       kept in a side table, so record_load always gives back the stored doubles.
+     the name as a handle into an interned, variable-length string arena; students
+       with the same name share one copy.
+   Student stays the public type: record_load materializes one. */
+
+#define RECORD_FIXED_ESCAPE 0xffffu
+#define RECORD_FIXED_MAX 10000u /* 100.00 */
+
+typedef struct Record {
+    int32_t roll;
+    uint16_t marks[NUM_SUBJECTS]; /* hundredths, or RECORD_FIXED_ESCAPE */
+    uint16_t attendance;
+    uint32_t name;                /* name arena handle */
+    uint32_t exact;               /* 0, or 1 + side-table slot with the exact values */
+    struct Record *next;          /* list link, owned by database.c */
+} Record;
+
+/* Hundredths of v when converting back gives exactly v, else RECORD_FIXED_ESCAPE */
+unsigned record_fixed(double v);
+
+/* New record holding s (next is NULL), or NULL when out of memory. */
+Record *record_create(const Student *s);
+
+/* Overwrite r with s, keeping next. Returns false (r unchanged) when out of memory. */
+bool record_store(Record *r, const Student *s);
+
+/* Release r and its share of the name (NULL is ignored). */
+void record_free(Record *r);
+
+/* Release every record, name and exact value at once. */
+void record_release_all(void);
+
+/* Materialize r (out->next is set to NULL). */
+void record_load(const Record *r, Student *out);
+
+/* Interned name; valid until the next record is created or changed. */
+const char *record_name(const Record *r);
+
+/* Bytes currently allocated for records, the name arena and the side table. */
+size_t record_memory(void);
+
+#endif /* RECORD_H */
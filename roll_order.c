@@ -0,0 +1,113 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include "roll_order.h"
+
+#define MAX_LEVEL 24 /* p = 1/4 covers ~2^48 keys */
+
+struct OrderNode {
+    int key;
+    int level;
+    void *value;
+    struct OrderNode *next[]; /* level entries */
+};
+
+static OrderNode *head = NULL; /* sentinel with MAX_LEVEL links */
+static int top_level = 1;
+static uint32_t rng_state = 2463534242u;
+
+static int random_level(void) {
+    /* xorshift32; two bits per level gives p = 1/4 */
+    uint32_t x = rng_state;
+    x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+    rng_state = x;
+    int lvl = 1;
+    while (lvl < MAX_LEVEL && (x & 3u) == 0) {
+        ++lvl;
+        x >>= 2;
+    }
+    return lvl;
+}
+
+static bool ensure_head(void) {
+    if (head) return true;
+    head = (OrderNode *)calloc(1, sizeof(OrderNode) + sizeof(OrderNode *) * MAX_LEVEL);
+    if (!head) return false;
+    head->level = MAX_LEVEL;
+    return true;
+}
+
+/* Fill update[] with the last node before key on every level */
+static OrderNode *find_preds(int key, OrderNode **update) {
+    OrderNode *x = head;
+    for (int i = top_level - 1; i >= 0; --i) {
+        while (x->next[i] && x->next[i]->key < key) x = x->next[i];
+        if (update) update[i] = x;
+    }
+    return x->next[0];
+}
+
+bool roll_order_insert(int roll, void *value) {
+    if (!ensure_head()) return false;
+    OrderNode *update[MAX_LEVEL];
+    OrderNode *x = find_preds(roll, update);
+    if (x && x->key == roll) {
+        x->value = value;
+        return true;
+    }
+    int lvl = random_level();
+    OrderNode *n = (OrderNode *)malloc(sizeof(OrderNode) + sizeof(OrderNode *) * (size_t)lvl);
+    if (!n) return false;
+    n->key = roll;
+    n->level = lvl;
+    n->value = value;
+    for (int i = top_level; i < lvl; ++i) update[i] = head;
+    if (lvl > top_level) top_level = lvl;
+    for (int i = 0; i < lvl; ++i) {
+        n->next[i] = update[i]->next[i];
+        update[i]->next[i] = n;
+    }
+    return true;
+}
+
+void roll_order_remove(int roll) {
+    if (!head) return;
+    OrderNode *update[MAX_LEVEL];
+    OrderNode *x = find_preds(roll, update);
+    if (!x || x->key != roll) return;
+    for (int i = 0; i < x->level; ++i) update[i]->next[i] = x->next[i];
+    free(x);
+    while (top_level > 1 && !head->next[top_level - 1]) --top_level;
+}
+
+void roll_order_clear(void) {
+    if (!head) return;
+    OrderNode *x = head->next[0];
+    while (x) {
+        OrderNode *n = x->next[0];
+        free(x);
+        x = n;
+    }
+    free(head);
+    head = NULL;
+    top_level = 1;
+}
+
+const OrderNode *roll_order_lower_bound(int roll) {
+    return head ? find_preds(roll, NULL) : NULL;
+}
+
+const OrderNode *roll_order_first(void) {
+    return head ? head->next[0] : NULL;
+}
+
+const OrderNode *roll_order_next(const OrderNode *n) {
+    return n ? n->next[0] : NULL;
+}
+
+int roll_order_key(const OrderNode *n) {
+    return n->key;
+}
+
+void *roll_order_value(const OrderNode *n) {
+    return n->value;
+}
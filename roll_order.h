@@ -0,0 +1,22 @@
+#ifndef ROLL_ORDER_H
+#define ROLL_ORDER_H
+
+#include <stdbool.h>
+
+/* Ordered index on roll number (skip list) maintained by database.c, so listings
+   and range scans walk records in roll order without sorting. */
+
+typedef struct OrderNode OrderNode;
+
+bool roll_order_insert(int roll, void *value);
+void roll_order_remove(int roll);
+void roll_order_clear(void);
+
+/* First node with key >= roll (NULL if none); roll_order_first is the smallest. */
+const OrderNode *roll_order_lower_bound(int roll);
+const OrderNode *roll_order_first(void);
+const OrderNode *roll_order_next(const OrderNode *n);
+int roll_order_key(const OrderNode *n);
+void *roll_order_value(const OrderNode *n);
+
+#endif /* ROLL_ORDER_H */
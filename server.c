@@ -0,0 +1,541 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "server.h"
+
+#ifndef _WIN32
+#include <signal.h>
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "protocol.h"
+#include "database.h"
+#include "query.h"
+#include "student.h"
+#include "metrics.h"
+
+#define SERVER_MAX_THREADS 64
+#define SERVER_MAX_CONNS 1024 /* open connections; more are refused */
+#define SERVER_POLL_MS 200    /* how often the poll loop checks for a stop signal */
+#define QUERY_TEXT_MAX 1024
+
+/* Readers (lookups, listings, rankings, queries) share the lock; writers and
+   db_stats, which may rescan and cache a column's min/max, hold it alone. */
+static pthread_rwlock_t db_lock;
+static volatile sig_atomic_t stop_requested = 0;
+
+/* A connection is always in exactly one place: idle in the poll loop's set, in the
+   ready queue with a request waiting, with a worker, or handed back to the poll loop.
+   So neither queue can hold more than SERVER_MAX_CONNS. */
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_cond = PTHREAD_COND_INITIALIZER;
+static int ready_fds[SERVER_MAX_CONNS];
+static int ready_head = 0, ready_count = 0;
+static int returned_fds[SERVER_MAX_CONNS]; /* served, to be polled again */
+static int returned_count = 0;
+static int open_conns = 0;
+static bool queue_closed = false;
+static int wake_pipe[2] = { -1, -1 };      /* workers wake the poll loop when handing back */
+static int active_fd[SERVER_MAX_THREADS]; /* connection each worker serves, -1 when idle */
+
+typedef struct {
+    int id;
+    Student *buf; /* PROTO_MAX_RECORDS results copied out under the lock */
+    ProtoWriter in, out;
+} Worker;
+
+static void on_stop_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static bool bad_request(ProtoWriter *out) {
+    proto_begin(out);
+    proto_put_u8(out, PROTO_BAD_REQUEST);
+    return false;
+}
+
+/* Every argument was read and nothing is left over */
+static bool fully_read(const ProtoReader *r) {
+    return !r->failed && r->pos == r->len;
+}
+
+static uint32_t cap_records(uint32_t max) {
+    return max > PROTO_MAX_RECORDS ? PROTO_MAX_RECORDS : max;
+}
+
+static void put_records(ProtoWriter *out, const Student *recs, uint32_t n) {
+    proto_put_u32(out, n);
+    for (uint32_t i = 0; i < n; ++i) proto_put_record(out, &recs[i]);
+}
+
+
+/* Mutations: one writer at a time, durable (per the checkpoint mode) before the reply */
+static ProtoStatus run_write(uint8_t op, const Student *rec) {
+    ProtoStatus st = PROTO_OK;
+    double marks[NUM_SUBJECTS];
+    memcpy(marks, rec->marks, sizeof(marks));
+    pthread_rwlock_wrlock(&db_lock);
+    if (op == OP_ADD) {
+        /* the student pool is not thread-safe, so allocate under the lock */
+        Student *s = create_student(rec->name, rec->roll, marks, rec->attendance);
+        if (!s) st = PROTO_FAILED;
+        else if (!db_add_student(s)) {
+            free_student(s);
+            st = PROTO_REJECTED;
+        }
+    } else if (op == OP_UPDATE) {
+        if (!db_update_student(rec->roll, rec->name[0] ? rec->name : NULL, marks, rec->attendance))
+            st = PROTO_NOT_FOUND;
+    } else if (!db_delete_by_roll(rec->roll)) {
+        st = PROTO_NOT_FOUND;
+    }
+    if (st == PROTO_OK && !db_commit()) st = PROTO_FAILED;
+    pthread_rwlock_unlock(&db_lock);
+    return st;
+}
+
+/* Build the reply to one request; false closes the connection after sending it */
+static bool handle_request(Worker *w, ProtoReader *r, ProtoWriter *out) {
+    uint8_t op = proto_get_u8(r);
+    switch (op) {
+        case OP_PING:
+            if (!fully_read(r)) return bad_request(out);
+            proto_put_u8(out, PROTO_OK);
+            return true;
+        case OP_COUNT: {
+            if (!fully_read(r)) return bad_request(out);
+            pthread_rwlock_rdlock(&db_lock);
+            size_t n = db_count();
+            pthread_rwlock_unlock(&db_lock);
+            proto_put_u8(out, PROTO_OK);
+            proto_put_u64(out, n);
+            return true;
+        }
+        case OP_GET: {
+            int32_t roll = proto_get_i32(r);
+            if (!fully_read(r)) return bad_request(out);
+            Student copy;
+            pthread_rwlock_rdlock(&db_lock);
+            const Student *s = db_search_by_roll(roll);
+            if (s) copy = *s;
+            pthread_rwlock_unlock(&db_lock);
+            proto_put_u8(out, s ? PROTO_OK : PROTO_NOT_FOUND);
+            if (s) proto_put_record(out, &copy);
+            return true;
+        }
+        case OP_FIND: {
+            uint8_t mode = proto_get_u8(r);
+            uint32_t max = cap_records(proto_get_u32(r));
+            char name[NAME_LEN];
+            proto_get_str(r, name, sizeof(name));
+            if (!fully_read(r) || mode > NAME_MATCH_PREFIX) return bad_request(out);
+            pthread_rwlock_rdlock(&db_lock);
+            int total = db_find_by_name(name, (NameMatch)mode, w->buf, (int)max);
+            pthread_rwlock_unlock(&db_lock);
+            proto_put_u8(out, PROTO_OK);
+            proto_put_u32(out, (uint32_t)total);
+            put_records(out, w->buf, (uint32_t)total < max ? (uint32_t)total : max);
+            return true;
+        }
+        case OP_LIST: {
+            DbCursor cursor;
+            int32_t lo = proto_get_i32(r), hi = proto_get_i32(r);
+            cursor.last_roll = proto_get_i32(r);
+            cursor.started = proto_get_u8(r) != 0;
+            uint32_t max = cap_records(proto_get_u32(r));
+            if (!fully_read(r)) return bad_request(out);
+            pthread_rwlock_rdlock(&db_lock);
+            int n = db_list_range(lo, hi, &cursor, w->buf, (int)max);
+            pthread_rwlock_unlock(&db_lock);
+            proto_put_u8(out, PROTO_OK);
+            put_records(out, w->buf, (uint32_t)n);
+            return true;
+        }
+        case OP_TOP: {
+            uint8_t key = proto_get_u8(r), highest = proto_get_u8(r);
+            uint32_t k = cap_records(proto_get_u32(r));
+            if (!fully_read(r) || key > RANK_BY_AVERAGE) return bad_request(out);
+            pthread_rwlock_rdlock(&db_lock);
+            int n = db_top_k(key, highest != 0, (int)k, w->buf);
+            pthread_rwlock_unlock(&db_lock);
+            proto_put_u8(out, PROTO_OK);
+            put_records(out, w->buf, (uint32_t)n);
+            return true;
+        }
+        case OP_RANK: {
+            int32_t roll = proto_get_i32(r);
+            uint8_t key = proto_get_u8(r);
+            if (!fully_read(r) || key > RANK_BY_AVERAGE) return bad_request(out);
+            int rank = 0;
+            size_t total = 0;
+            pthread_rwlock_rdlock(&db_lock);
+            bool found = db_rank_of(roll, key, &rank, &total);
+            pthread_rwlock_unlock(&db_lock);
+            proto_put_u8(out, found ? PROTO_OK : PROTO_NOT_FOUND);
+            if (found) {
+                proto_put_u32(out, (uint32_t)rank);
+                proto_put_u64(out, total);
+            }
+            return true;
+        }
+        case OP_STATS: {
+            uint8_t field = proto_get_u8(r);
+            if (!fully_read(r) || field >= DB_FIELD_COUNT) return bad_request(out);
+            DbStats st;
+            pthread_rwlock_wrlock(&db_lock);
+            db_stats(field, &st);
+            pthread_rwlock_unlock(&db_lock);
+            proto_put_u8(out, PROTO_OK);
+            proto_put_stats(out, &st);
+            return true;
+        }
+        case OP_QUERY: {
+            uint32_t max = cap_records(proto_get_u32(r));
+            char text[QUERY_TEXT_MAX], err[128];
+            proto_get_str(r, text, sizeof(text));
+            if (!fully_read(r)) return bad_request(out);
+            Query q;
+            if (!query_parse(text, &q, err, sizeof(err))) {
+                proto_put_u8(out, PROTO_REJECTED);
+                proto_put_str(out, err);
+                return true;
+            }
+            pthread_rwlock_rdlock(&db_lock);
+            size_t total = query_run(&q, w->buf, max);
+            pthread_rwlock_unlock(&db_lock);
+            if (total == (size_t)-1) {
+                proto_put_u8(out, PROTO_FAILED);
+                return true;
+            }
+            proto_put_u8(out, PROTO_OK);
+            proto_put_u64(out, total);
+            put_records(out, w->buf, total < max ? (uint32_t)total : max);
+            return true;
+        }
+        case OP_ADD:
+        case OP_UPDATE:
+        case OP_DELETE: {
+            Student rec;
+            memset(&rec, 0, sizeof(rec));
+            if (op == OP_DELETE) rec.roll = proto_get_i32(r);
+            else proto_get_record(r, &rec);
+            if (!fully_read(r)) return bad_request(out);
+            if (op != OP_DELETE && !validate_marks_and_attendance(rec.marks, rec.attendance)) {
+                proto_put_u8(out, PROTO_REJECTED);
+                return true;
+            }
+            proto_put_u8(out, (uint8_t)run_write(op, &rec));
+            return true;
+        }
+        default:
+            return bad_request(out);
+    }
+}
+
+/* Stream the last committed version in roll order. Only the snapshot is pinned, not
+   db_lock, so writers go on while a slow client drains a large dump. */
+static bool serve_dump(Worker *w, int fd) {
+    DbSnapshot snap;
+    const Student **order = NULL;
+    bool pinned = db_snapshot_open(&snap);
+    size_t n = pinned ? db_snapshot_count(&snap) : 0;
+    if (pinned) order = (const Student **)malloc(sizeof(Student *) * (n ? n : 1));
+    bool sent;
+    if (!order || !db_snapshot_by_roll(&snap, order)) {
+        proto_begin(&w->out);
+        proto_put_u8(&w->out, PROTO_FAILED);
+        sent = proto_send(fd, &w->out);
+    } else {
+        size_t pos = 0;
+        uint32_t k;
+        do {
+            k = n - pos < PROTO_MAX_RECORDS ? (uint32_t)(n - pos) : PROTO_MAX_RECORDS;
+            proto_begin(&w->out);
+            proto_put_u8(&w->out, PROTO_OK);
+            proto_put_u32(&w->out, k);
+            for (uint32_t i = 0; i < k; ++i) proto_put_record(&w->out, order[pos + i]);
+            pos += k;
+            sent = proto_send(fd, &w->out);
+        } while (sent && k > 0);
+    }
+    free(order);
+    if (pinned) db_snapshot_close(&snap);
+    return sent;
+}
+
+/* Answer one request on fd; false when the connection should be closed */
+static bool serve_request(Worker *w, int fd) {
+    ProtoReader req;
+    if (!proto_recv(fd, &w->in, &req)) return false;
+    METRIC_TIMER_START(t0);
+    if (req.len == 1 && req.data[0] == OP_DUMP) {
+        bool sent = serve_dump(w, fd);
+        METRIC_TIMER_STOP(MET_SERVER_REQUEST, t0);
+        return sent;
+    }
+    proto_begin(&w->out);
+    bool keep = handle_request(w, &req, &w->out);
+    if (w->out.failed) {
+        /* could not build the reply (out of memory) */
+        proto_begin(&w->out);
+        proto_put_u8(&w->out, PROTO_FAILED);
+    }
+    METRIC_TIMER_STOP(MET_SERVER_REQUEST, t0);
+    return proto_send(fd, &w->out) && keep;
+}
+
+/* A worker takes a connection only while it has a request waiting, so a few threads
+   can serve many mostly idle clients. */
+static void *worker_main(void *arg) {
+    Worker *w = (Worker *)arg;
+    for (;;) {
+        pthread_mutex_lock(&queue_lock);
+        while (ready_count == 0 && !queue_closed) pthread_cond_wait(&queue_cond, &queue_lock);
+        if (queue_closed) {
+            pthread_mutex_unlock(&queue_lock);
+            break;
+        }
+        int fd = ready_fds[ready_head];
+        ready_head = (ready_head + 1) % SERVER_MAX_CONNS;
+        --ready_count;
+        active_fd[w->id] = fd;
+        pthread_mutex_unlock(&queue_lock);
+
+        bool keep = serve_request(w, fd);
+
+        pthread_mutex_lock(&queue_lock);
+        active_fd[w->id] = -1;
+        if (keep && !queue_closed) {
+            returned_fds[returned_count++] = fd;
+            char c = 0;
+            if (write(wake_pipe[1], &c, 1) < 0) {
+                /* pipe full: the poll loop is already awake */
+            }
+        } else {
+            close(fd);
+            --open_conns;
+        }
+        pthread_mutex_unlock(&queue_lock);
+    }
+    return NULL;
+}
+
+static int listen_socket(const ServerOptions *opt) {
+    int fd;
+    if (opt->socket_path) {
+        struct sockaddr_un addr;
+        if (strlen(opt->socket_path) >= sizeof(addr.sun_path)) {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strcpy(addr.sun_path, opt->socket_path);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        unlink(opt->socket_path); /* left behind by a previous run */
+        if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    } else {
+        /* loopback only: the protocol has no authentication */
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)opt->port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+    }
+    if (listen(fd, 128) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int online_cpus(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    if (n > 0) return n > SERVER_MAX_THREADS ? SERVER_MAX_THREADS : (int)n;
+#endif
+    return 1;
+}
+
+int server_run(const ServerOptions *opt) {
+    int threads = opt->threads > 0 ? opt->threads : online_cpus();
+    if (threads > SERVER_MAX_THREADS) threads = SERVER_MAX_THREADS;
+    if (!opt->socket_path && (opt->port <= 0 || opt->port > 65535)) {
+        fprintf(stderr, "Invalid port %d.\n", opt->port);
+        return 1;
+    }
+    int lfd = listen_socket(opt);
+    if (lfd < 0) {
+        if (opt->socket_path) fprintf(stderr, "Cannot listen on %s: %s\n", opt->socket_path, strerror(errno));
+        else fprintf(stderr, "Cannot listen on 127.0.0.1:%d: %s\n", opt->port, strerror(errno));
+        return 1;
+    }
+    if (pipe(wake_pipe) != 0) {
+        fprintf(stderr, "Cannot create a pipe: %s\n", strerror(errno));
+        close(lfd);
+        return 1;
+    }
+    fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+    /* the default lets a steady stream of readers starve writers */
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+    pthread_rwlock_init(&db_lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+    if (!db_snapshots_enable(true)) fprintf(stderr, "Warning: not enough memory for snapshots; dumps will fail.\n");
+
+    struct sigaction sa, old_int, old_term, old_pipe;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop_signal; /* no SA_RESTART: poll returns early */
+    sigemptyset(&sa.sa_mask);
+    stop_requested = 0;
+    sigaction(SIGINT, &sa, &old_int);
+    sigaction(SIGTERM, &sa, &old_term);
+    sa.sa_handler = SIG_IGN;
+    sigaction(SIGPIPE, &sa, &old_pipe);
+
+    ready_head = ready_count = returned_count = open_conns = 0;
+    queue_closed = false;
+    Worker *workers = (Worker *)calloc((size_t)threads, sizeof(Worker));
+    pthread_t *tids = (pthread_t *)calloc((size_t)threads, sizeof(pthread_t));
+    int started = 0;
+    for (int t = 0; workers && tids && t < threads; ++t) {
+        workers[t].id = t;
+        workers[t].buf = (Student *)malloc(sizeof(Student) * PROTO_MAX_RECORDS);
+        active_fd[t] = -1;
+        if (!workers[t].buf || pthread_create(&tids[t], NULL, worker_main, &workers[t]) != 0) {
+            free(workers[t].buf);
+            break;
+        }
+        ++started;
+    }
+    int status = 0;
+    if (started == 0) {
+        fprintf(stderr, "Cannot start worker threads.\n");
+        status = 1;
+        stop_requested = 1;
+    } else {
+        if (opt->socket_path) fprintf(stderr, "Serving %zu students on %s", db_count(), opt->socket_path);
+        else fprintf(stderr, "Serving %zu students on 127.0.0.1:%d", db_count(), opt->port);
+        fprintf(stderr, " with %d threads (Ctrl-C stops).\n", started);
+    }
+
+    /* poll set: the listening socket, the wake pipe, then every idle connection */
+    struct pollfd *pfd = (struct pollfd *)malloc(sizeof(struct pollfd) * (SERVER_MAX_CONNS + 2));
+    int nidle = 0;
+    if (!pfd) {
+        fprintf(stderr, "Out of memory.\n");
+        status = 1;
+        stop_requested = 1;
+    }
+    while (!stop_requested) {
+        pfd[0] = (struct pollfd){ lfd, POLLIN, 0 };
+        pfd[1] = (struct pollfd){ wake_pipe[0], POLLIN, 0 };
+        if (poll(pfd, (nfds_t)(nidle + 2), SERVER_POLL_MS) <= 0) continue;
+
+        /* connections with a request (or a hangup) waiting go to the workers */
+        pthread_mutex_lock(&queue_lock);
+        int kept = 0;
+        for (int i = 0; i < nidle; ++i) {
+            struct pollfd *p = &pfd[2 + i];
+            if (p->revents) {
+                ready_fds[(ready_head + ready_count) % SERVER_MAX_CONNS] = p->fd;
+                ++ready_count;
+            } else {
+                pfd[2 + kept++] = (struct pollfd){ p->fd, POLLIN, 0 };
+            }
+        }
+        nidle = kept;
+        if (ready_count > 0) pthread_cond_broadcast(&queue_cond);
+        if (pfd[1].revents) {
+            char drain[64];
+            while (read(wake_pipe[0], drain, sizeof(drain)) > 0) {
+            }
+            for (int i = 0; i < returned_count; ++i) pfd[2 + nidle++] = (struct pollfd){ returned_fds[i], POLLIN, 0 };
+            returned_count = 0;
+        }
+        pthread_mutex_unlock(&queue_lock);
+
+        if (pfd[0].revents) {
+            int fd = accept(lfd, NULL, NULL);
+            if (fd < 0) continue;
+            pthread_mutex_lock(&queue_lock);
+            bool full = open_conns == SERVER_MAX_CONNS;
+            if (!full) ++open_conns;
+            pthread_mutex_unlock(&queue_lock);
+            if (full) {
+                close(fd); /* overloaded: the client sees the connection drop */
+                continue;
+            }
+            if (!opt->socket_path) {
+                int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            }
+            pfd[2 + nidle++] = (struct pollfd){ fd, POLLIN, 0 };
+        }
+    }
+
+    /* stop: wake workers blocked on a client, let them finish, close everything */
+    pthread_mutex_lock(&queue_lock);
+    queue_closed = true;
+    for (int t = 0; t < started; ++t)
+        if (active_fd[t] >= 0) shutdown(active_fd[t], SHUT_RDWR);
+    pthread_cond_broadcast(&queue_cond);
+    pthread_mutex_unlock(&queue_lock);
+    for (int t = 0; t < started; ++t) {
+        pthread_join(tids[t], NULL);
+        free(workers[t].buf);
+        proto_writer_free(&workers[t].in);
+        proto_writer_free(&workers[t].out);
+    }
+    for (int i = 0; i < nidle; ++i) close(pfd[2 + i].fd);
+    for (; ready_count > 0; --ready_count, ready_head = (ready_head + 1) % SERVER_MAX_CONNS) close(ready_fds[ready_head]);
+    for (int i = 0; i < returned_count; ++i) close(returned_fds[i]);
+    free(pfd);
+    db_snapshots_enable(false);
+    free(workers);
+    free(tids);
+    close(lfd);
+    close(wake_pipe[0]);
+    close(wake_pipe[1]);
+    if (opt->socket_path) unlink(opt->socket_path);
+    sigaction(SIGINT, &old_int, NULL);
+    sigaction(SIGTERM, &old_term, NULL);
+    sigaction(SIGPIPE, &old_pipe, NULL);
+    pthread_rwlock_destroy(&db_lock);
+    return status;
+}
+
+#else /* _WIN32 */
+
+int server_run(const ServerOptions *opt) {
+    (void)opt;
+    fprintf(stderr, "Server mode needs POSIX sockets and is not available on Windows.\n");
+    return 1;
+}
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/* Daemon mode: serves the database.h operations to many clients at once over
+   the binary protocol in protocol.h. */
+
+typedef struct {
+    const char *socket_path; /* Unix domain socket to listen on; NULL for TCP */
+    int port;                /* TCP port on 127.0.0.1 when socket_path is NULL */
+    int threads;             /* worker threads; 0 = number of online CPUs */
+} ServerOptions;
+
+/* Serve until SIGINT or SIGTERM. Each worker thread serves one connection at a
+   time. Read requests run side by side under a shared lock; add, update and delete
+   take it exclusively, one at a time, and are committed with db_commit before the
+   reply. Dumps read a snapshot (db_snapshot_open) and take no lock. The database
+   must already be loaded. Returns a process exit status. */
+int server_run(const ServerOptions *opt);
+
+#endif /* SERVER_H */
@@ -0,0 +1,705 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "storage.h"
+#include "lz.h"
+#include "record.h"
+#include "metrics.h"
+#include <pthread.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <io.h>
+#include <windows.h>
+#endif
+
+_Static_assert(sizeof(StorageHeader) == 64, "StorageHeader layout changed");
+_Static_assert(sizeof(StorageRecord) == 4 + NAME_LEN + 8 * NUM_SUBJECTS + 8, "StorageRecord must have no padding");
+_Static_assert(NAME_LEN <= 128, "name lengths are one-byte varints");
+
+#define VALUE_COLS (NUM_SUBJECTS + 1) /* marks, then attendance */
+#define BLOCK_HEADER 8
+/* Largest block payload: 5-byte rolls, every value an exception, full-length names */
+#define RAW_BOUND ((size_t)STORAGE_BLOCK_RECORDS * (5 + VALUE_COLS * (2 + 5 + 8) + 1 + NAME_LEN) + VALUE_COLS * 5)
+
+#define STORAGE_MAX_THREADS 16
+
+static bool compress_blocks = true;
+static int io_threads = 0; /* 0: one per online CPU */
+
+void storage_set_compression(bool on) {
+    compress_blocks = on;
+}
+
+void storage_set_threads(int n) {
+    io_threads = n < 0 ? 0 : n;
+}
+
+/* Worker threads for block encoding and decoding */
+static int thread_count(void) {
+    long n = io_threads;
+#ifndef _WIN32
+    if (n == 0) n = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (n < 1) return 1;
+    return n > STORAGE_MAX_THREADS ? STORAGE_MAX_THREADS : (int)n;
+}
+
+/* Layout of the original format: raw Student structs including the next pointer */
+typedef struct LegacyStudent {
+    char name[NAME_LEN];
+    int roll;
+    double marks[NUM_SUBJECTS];
+    double attendance;
+    struct LegacyStudent *next;
+} LegacyStudent;
+
+static uint32_t bswap32(uint32_t x) {
+    return (x >> 24) | ((x >> 8) & 0xff00U) | ((x << 8) & 0xff0000U) | (x << 24);
+}
+
+static double bswap_double(double d) {
+    unsigned char b[sizeof(double)], r[sizeof(double)];
+    memcpy(b, &d, sizeof(d));
+    for (size_t i = 0; i < sizeof(d); ++i) r[i] = b[sizeof(d) - 1 - i];
+    memcpy(&d, r, sizeof(d));
+    return d;
+}
+
+/* --- version 3 encoding helpers --- */
+
+static unsigned char *put_varint(unsigned char *p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (unsigned char)(v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (unsigned char)v;
+    return p;
+}
+
+static unsigned char *put_le(unsigned char *p, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) *p++ = (unsigned char)(v >> (8 * i));
+    return p;
+}
+
+/* Bounded reader over a block payload; any overrun sets bad */
+typedef struct {
+    const unsigned char *p;
+    const unsigned char *end;
+    bool bad;
+} Cursor;
+
+static uint64_t get_varint(Cursor *c) {
+    uint64_t v = 0;
+    for (int shift = 0; shift < 64 && c->p < c->end; shift += 7) {
+        unsigned char b = *c->p++;
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return v;
+    }
+    c->bad = true;
+    return 0;
+}
+
+static uint64_t get_le(Cursor *c, int bytes) {
+    if (c->end - c->p < bytes) {
+        c->bad = true;
+        return 0;
+    }
+    uint64_t v = 0;
+    for (int i = 0; i < bytes; ++i) v |= (uint64_t)c->p[i] << (8 * i);
+    c->p += bytes;
+    return v;
+}
+
+static double value_of(const Student *s, int col) {
+    return col < NUM_SUBJECTS ? s->marks[col] : s->attendance;
+}
+
+static void set_value(Student *s, int col, double v) {
+    if (col < NUM_SUBJECTS) s->marks[col] = v;
+    else s->attendance = v;
+}
+
+static bool map_file(const char *filename, StorageView *v, bool *missing) {
+    *missing = false;
+#ifndef _WIN32
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        *missing = true;
+        return true;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return false;
+    }
+    v->map_len = (size_t)st.st_size;
+    if (v->map_len == 0) {
+        close(fd);
+        return true;
+    }
+    void *p = mmap(NULL, v->map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+    madvise(p, v->map_len, MADV_SEQUENTIAL);
+    v->map = p;
+    return true;
+#else
+    /* no mmap: read the whole file with one call */
+    FILE *f = fopen(filename, "rb");
+    if (!f) {
+        *missing = true;
+        return true;
+    }
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (len <= 0) {
+        fclose(f);
+        return len == 0;
+    }
+    v->map = malloc((size_t)len);
+    if (!v->map || fread(v->map, 1, (size_t)len, f) != (size_t)len) {
+        free(v->map);
+        v->map = NULL;
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+    v->map_len = (size_t)len;
+    return true;
+#endif
+}
+
+/* Find every block of a version 3 file (v->records is the first one) */
+static bool index_blocks(StorageView *v, uint32_t block_records) {
+    if (block_records == 0 || block_records > STORAGE_BLOCK_RECORDS) return false;
+    const unsigned char *end = (const unsigned char *)v->map + v->map_len;
+    uint64_t blocks = (v->count + block_records - 1) / block_records;
+    if (blocks > (uint64_t)(end - v->records) / BLOCK_HEADER) return false;
+    v->blocks = (size_t *)malloc(sizeof(size_t) * (blocks ? blocks : 1));
+    if (!v->blocks) return false;
+    size_t off = (size_t)(v->records - (const unsigned char *)v->map);
+    for (uint64_t b = 0; b < blocks; ++b) {
+        Cursor c = { (const unsigned char *)v->map + off, end, false };
+        uint64_t stored = get_le(&c, 4);
+        /* the rest of the header (raw size) and the payload must both be there */
+        if (c.bad || stored + 4 > (uint64_t)(end - c.p)) return false;
+        v->blocks[b] = off;
+        off += BLOCK_HEADER + (size_t)stored;
+    }
+    v->block_count = blocks;
+    v->block_records = block_records;
+    return true;
+}
+
+/* Decode block b into out (block_records entries); *scratch is allocated on first
+   use and kept by the caller. Touches nothing else, so threads may decode side by side. */
+static bool decode_block_into(const StorageView *v, uint64_t b, Student *out, unsigned char **scratch) {
+    size_t n = (size_t)(b + 1 < v->block_count ? v->block_records : v->count - b * v->block_records);
+    const unsigned char *p = (const unsigned char *)v->map + v->blocks[b];
+    Cursor c = { p, p + BLOCK_HEADER, false };
+    size_t stored = (size_t)get_le(&c, 4), raw = (size_t)get_le(&c, 4);
+    c.end = c.p + stored;
+    if (raw) {
+        if (raw > RAW_BOUND) return false;
+        if (!*scratch && !(*scratch = (unsigned char *)malloc(RAW_BOUND))) return false;
+        if (!lz_decompress(c.p, stored, *scratch, raw)) return false;
+        c.p = *scratch;
+        c.end = *scratch + raw;
+    }
+
+    uint64_t z = get_varint(&c);
+    uint32_t roll = (uint32_t)((z >> 1) ^ (~(z & 1) + 1));
+    for (size_t i = 0; i < n; ++i) {
+        if (i > 0) roll += (uint32_t)get_varint(&c);
+        out[i].roll = (int32_t)roll;
+        out[i].next = NULL;
+    }
+    for (int col = 0; col < VALUE_COLS; ++col) {
+        size_t escaped = 0;
+        for (size_t i = 0; i < n; ++i) {
+            unsigned f = (unsigned)get_le(&c, 2);
+            if (f == RECORD_FIXED_ESCAPE) ++escaped;
+            else if (f > RECORD_FIXED_MAX) c.bad = true;
+            set_value(&out[i], col, f == RECORD_FIXED_ESCAPE ? NAN : f / 100.0);
+        }
+        if (get_varint(&c) != escaped) c.bad = true;
+        for (size_t e = 0; e < escaped && !c.bad; ++e) {
+            uint64_t row = get_varint(&c), bits = get_le(&c, 8);
+            double d;
+            memcpy(&d, &bits, sizeof(d));
+            if (row >= n) c.bad = true;
+            else set_value(&out[row], col, d);
+        }
+    }
+    unsigned char lens[STORAGE_BLOCK_RECORDS];
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t len = get_varint(&c);
+        if (len >= NAME_LEN) c.bad = true;
+        lens[i] = (unsigned char)(len < NAME_LEN ? len : 0);
+    }
+    for (size_t i = 0; i < n && !c.bad; ++i) {
+        if ((size_t)(c.end - c.p) < lens[i]) {
+            c.bad = true;
+            break;
+        }
+        memcpy(out[i].name, c.p, lens[i]);
+        out[i].name[lens[i]] = '\0';
+        c.p += lens[i];
+    }
+    return !c.bad && c.p == c.end;
+}
+
+bool storage_map(const char *filename, StorageView *v) {
+    memset(v, 0, sizeof(*v));
+    bool missing;
+    if (!map_file(filename, v, &missing)) return false;
+    if (missing || v->map_len == 0) return true;
+    METRIC_ADD(MET_BYTES_READ, v->map_len);
+
+    const unsigned char *base = (const unsigned char *)v->map;
+    StorageHeader h;
+    if (v->map_len >= sizeof(h) && memcmp(base, STORAGE_MAGIC, sizeof(h.magic)) == 0) {
+        memcpy(&h, base, sizeof(h));
+        if (h.endian_tag == bswap32(STORAGE_ENDIAN_TAG)) {
+            v->byteswap = true;
+            h.version = bswap32(h.version);
+            h.record_size = bswap32(h.record_size);
+            h.header_size = bswap32(h.header_size);
+            h.block_records = bswap32(h.block_records);
+            uint32_t lo = bswap32((uint32_t)(h.record_count >> 32));
+            uint32_t hi = bswap32((uint32_t)h.record_count);
+            h.record_count = ((uint64_t)hi << 32) | lo;
+        } else if (h.endian_tag != STORAGE_ENDIAN_TAG) {
+            storage_unmap(v);
+            return false;
+        }
+        if (h.header_size < sizeof(StorageHeader) || h.header_size > v->map_len) {
+            storage_unmap(v);
+            return false;
+        }
+        v->records = base + h.header_size;
+        v->count = h.record_count;
+        if (h.version == STORAGE_VERSION) {
+            if (!index_blocks(v, h.block_records)) {
+                storage_unmap(v);
+                return false;
+            }
+            return true;
+        }
+        if (h.version != STORAGE_VERSION_FIXED || h.record_size != sizeof(StorageRecord) ||
+            h.record_count > (v->map_len - h.header_size) / h.record_size) {
+            storage_unmap(v);
+            return false;
+        }
+        v->record_size = h.record_size;
+        v->outdated = true;
+        return true;
+    }
+
+    /* Migration path: headerless file of raw structs from the previous format */
+    if (v->map_len % sizeof(LegacyStudent) != 0) {
+        storage_unmap(v);
+        return false;
+    }
+    v->legacy = true;
+    v->outdated = true;
+    v->records = base;
+    v->count = v->map_len / sizeof(LegacyStudent);
+    v->record_size = sizeof(LegacyStudent);
+    return true;
+}
+
+/* Record i of a fixed-layout (version 2 or raw) file */
+static void decode_fixed(const StorageView *v, uint64_t i, Student *out) {
+    const unsigned char *p = v->records + i * v->record_size;
+    if (v->legacy) {
+        LegacyStudent ls;
+        memcpy(&ls, p, sizeof(ls));
+        memcpy(out->name, ls.name, NAME_LEN);
+        out->roll = ls.roll;
+        for (int k = 0; k < NUM_SUBJECTS; ++k) out->marks[k] = ls.marks[k];
+        out->attendance = ls.attendance;
+    } else {
+        StorageRecord r;
+        memcpy(&r, p, sizeof(r));
+        memcpy(out->name, r.name, NAME_LEN);
+        out->roll = r.roll;
+        for (int k = 0; k < NUM_SUBJECTS; ++k) out->marks[k] = r.marks[k];
+        out->attendance = r.attendance;
+        if (v->byteswap) {
+            out->roll = (int)bswap32((uint32_t)out->roll);
+            for (int k = 0; k < NUM_SUBJECTS; ++k) out->marks[k] = bswap_double(out->marks[k]);
+            out->attendance = bswap_double(out->attendance);
+        }
+    }
+    out->name[NAME_LEN-1] = '\0';
+    out->next = NULL;
+}
+
+/* --- parallel scan: chunks decoded on worker threads, handed over in order --- */
+
+typedef struct {
+    const StorageView *v;
+    uint64_t chunk;
+    Student *recs; /* this thread's partition: the decoded chunk */
+    size_t n;
+    unsigned char *scratch;
+    bool ok;
+    pthread_t tid;
+    bool started;
+} ScanJob;
+
+static void *scan_job(void *arg) {
+    ScanJob *j = (ScanJob *)arg;
+    const StorageView *v = j->v;
+    uint64_t first = j->chunk * STORAGE_BLOCK_RECORDS;
+    if (v->blocks) {
+        j->n = (size_t)(j->chunk + 1 < v->block_count ? v->block_records : v->count - j->chunk * v->block_records);
+        j->ok = decode_block_into(v, j->chunk, j->recs, &j->scratch);
+    } else {
+        j->n = (size_t)(v->count - first < STORAGE_BLOCK_RECORDS ? v->count - first : STORAGE_BLOCK_RECORDS);
+        for (size_t i = 0; i < j->n; ++i) decode_fixed(v, first + i, &j->recs[i]);
+        j->ok = true;
+    }
+    return NULL;
+}
+
+/* Start decoding chunks k, k+1, ... (in scan order) on up to threads jobs; returns how many */
+static int scan_round_start(ScanJob *jobs, int threads, uint64_t k, uint64_t chunks, bool backwards) {
+    int m = 0;
+    for (; m < threads && k < chunks; ++m, ++k) {
+        jobs[m].chunk = backwards ? chunks - 1 - k : k;
+        /* one thread: decode inline; a failed create also falls back to that */
+        jobs[m].started = threads > 1 && pthread_create(&jobs[m].tid, NULL, scan_job, &jobs[m]) == 0;
+        if (!jobs[m].started) scan_job(&jobs[m]);
+    }
+    return m;
+}
+
+static void scan_round_join(ScanJob *jobs, int m) {
+    for (int t = 0; t < m; ++t)
+        if (jobs[t].started) pthread_join(jobs[t].tid, NULL);
+}
+
+bool storage_scan(const StorageView *v, bool backwards, bool (*fn)(const Student *recs, size_t n, void *ctx), void *ctx) {
+    uint64_t per = v->blocks ? v->block_records : STORAGE_BLOCK_RECORDS;
+    uint64_t chunks = (v->count + per - 1) / per;
+    if (chunks == 0) return true;
+    int threads = thread_count();
+    if ((uint64_t)threads > chunks) threads = (int)chunks;
+    /* two sets of partitions: one decoding while fn consumes the other */
+    ScanJob *jobs = (ScanJob *)calloc(2 * (size_t)threads, sizeof(ScanJob));
+    bool ok = jobs != NULL;
+    for (int t = 0; ok && t < 2 * threads; ++t) {
+        jobs[t].v = v;
+        jobs[t].recs = (Student *)malloc(sizeof(Student) * per);
+        if (!jobs[t].recs) ok = false;
+    }
+    ScanJob *cur = ok ? jobs : NULL, *next = ok ? jobs + threads : NULL;
+    uint64_t k = 0;
+    int m = ok ? scan_round_start(cur, threads, k, chunks, backwards) : 0;
+    k += (uint64_t)m;
+    while (m > 0) {
+        scan_round_join(cur, m);
+        int m_next = ok ? scan_round_start(next, threads, k, chunks, backwards) : 0;
+        k += (uint64_t)m_next;
+        for (int t = 0; ok && t < m; ++t) ok = cur[t].ok && fn(cur[t].recs, cur[t].n, ctx);
+        ScanJob *swap = cur;
+        cur = next;
+        next = swap;
+        m = m_next;
+    }
+    for (int t = 0; jobs && t < 2 * threads; ++t) {
+        free(jobs[t].recs);
+        free(jobs[t].scratch);
+    }
+    free(jobs);
+    return ok;
+}
+
+void storage_unmap(StorageView *v) {
+    free(v->blocks);
+    if (v->map) {
+#ifndef _WIN32
+        munmap(v->map, v->map_len);
+#else
+        free(v->map);
+#endif
+    }
+    memset(v, 0, sizeof(*v));
+}
+
+bool storage_sync(FILE *f) {
+    if (fflush(f) != 0) return false;
+#ifndef _WIN32
+    return fsync(fileno(f)) == 0;
+#else
+    return _commit(_fileno(f)) == 0;
+#endif
+}
+
+bool storage_replace(const char *tmp_path, const char *path) {
+#ifndef _WIN32
+    if (rename(tmp_path, path) != 0) return false;
+    /* the new directory entry must be on disk too */
+    char dir[512];
+    const char *slash = strrchr(path, '/');
+    if (slash) snprintf(dir, sizeof(dir), "%.*s", (int)(slash - path) + (slash == path), path);
+    else snprintf(dir, sizeof(dir), ".");
+    int fd = open(dir, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    return true;
+#else
+    return MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#endif
+}
+
+/* Write len bytes at off without moving a shared file position */
+static bool write_at(FILE *f, const void *data, size_t len, uint64_t off) {
+#ifndef _WIN32
+    const char *p = (const char *)data;
+    while (len > 0) {
+        ssize_t n = pwrite(fileno(f), p, len, (off_t)off);
+        if (n <= 0) return false;
+        p += n;
+        len -= (size_t)n;
+        off += (uint64_t)n;
+    }
+    return true;
+#else
+    /* no pwrite: seek and write under one lock */
+    static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_mutex_lock(&lock);
+    bool ok = _fseeki64(f, (__int64)off, SEEK_SET) == 0 && fwrite(data, 1, len, f) == len && fflush(f) == 0;
+    pthread_mutex_unlock(&lock);
+    return ok;
+#endif
+}
+
+/* One block being filled, then encoded and written by its own thread */
+struct StorageSlot {
+    Student *block;
+    size_t n;
+    unsigned char *raw;    /* block header + payload */
+    unsigned char *packed; /* block header + compressed payload */
+    struct WriteRound *round;
+    int index;
+    pthread_t tid;
+    bool started;
+};
+
+/* Blocks encoded side by side; each takes the next file offset in slot order */
+typedef struct WriteRound {
+    StorageWriter *w;
+    pthread_mutex_t lock;
+    pthread_cond_t turn;
+    int next;        /* slot whose turn it is to take an offset */
+    uint64_t offset; /* where that slot's block goes */
+    bool failed;
+} WriteRound;
+
+typedef struct {
+    int32_t roll;
+    uint32_t pos;
+} RollPos;
+
+static int cmp_roll_pos(const void *a, const void *b) {
+    const RollPos *x = (const RollPos *)a, *y = (const RollPos *)b;
+    if (x->roll != y->roll) return x->roll < y->roll ? -1 : 1;
+    return x->pos < y->pos ? -1 : x->pos > y->pos; /* stable: a later duplicate stays later */
+}
+
+/* Encode a slot's records (sorted by roll) into raw + BLOCK_HEADER; returns the
+   payload size, or 0 when memory runs out */
+static size_t encode_block(struct StorageSlot *slot) {
+    size_t n = slot->n;
+    if (n == 0) return 0; /* flush_round skips empty slots */
+    const Student *r[STORAGE_BLOCK_RECORDS];
+    bool sorted = true;
+    for (size_t i = 0; i < n; ++i) {
+        r[i] = &slot->block[i];
+        if (i > 0 && r[i]->roll < r[i - 1]->roll) sorted = false;
+    }
+    if (!sorted) {
+        RollPos *keys = (RollPos *)malloc(sizeof(RollPos) * n);
+        if (!keys) return 0;
+        for (size_t i = 0; i < n; ++i) keys[i] = (RollPos){ slot->block[i].roll, (uint32_t)i };
+        qsort(keys, n, sizeof(RollPos), cmp_roll_pos);
+        for (size_t i = 0; i < n; ++i) r[i] = &slot->block[keys[i].pos];
+        free(keys);
+    }
+
+    unsigned char *p = slot->raw + BLOCK_HEADER;
+    uint32_t first = (uint32_t)r[0]->roll;
+    p = put_varint(p, (first << 1) ^ (uint32_t)-(int32_t)(first >> 31));
+    for (size_t i = 1; i < n; ++i) p = put_varint(p, (uint32_t)r[i]->roll - (uint32_t)r[i - 1]->roll);
+    for (int col = 0; col < VALUE_COLS; ++col) {
+        size_t escaped = 0;
+        for (size_t i = 0; i < n; ++i) {
+            unsigned f = record_fixed(value_of(r[i], col));
+            p = put_le(p, f, 2);
+            escaped += f == RECORD_FIXED_ESCAPE;
+        }
+        p = put_varint(p, escaped);
+        for (size_t i = 0; escaped > 0 && i < n; ++i) {
+            double d = value_of(r[i], col);
+            if (record_fixed(d) != RECORD_FIXED_ESCAPE) continue;
+            uint64_t bits;
+            memcpy(&bits, &d, sizeof(bits));
+            p = put_le(put_varint(p, i), bits, 8);
+        }
+    }
+    size_t lens[STORAGE_BLOCK_RECORDS];
+    for (size_t i = 0; i < n; ++i) {
+        lens[i] = strnlen(r[i]->name, NAME_LEN - 1);
+        p = put_varint(p, lens[i]);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        memcpy(p, r[i]->name, lens[i]);
+        p += lens[i];
+    }
+    return (size_t)(p - slot->raw) - BLOCK_HEADER;
+}
+
+/* Encode and compress the slot's block, take the next offset in turn, write it there */
+static void *write_slot(void *arg) {
+    struct StorageSlot *slot = (struct StorageSlot *)arg;
+    WriteRound *round = slot->round;
+    size_t raw = encode_block(slot);
+    size_t packed = raw && compress_blocks
+        ? lz_compress(slot->raw + BLOCK_HEADER, raw, slot->packed + BLOCK_HEADER, raw - raw / 8) : 0;
+    unsigned char *data = packed ? slot->packed : slot->raw;
+    put_le(put_le(data, packed ? packed : raw, 4), packed ? raw : 0, 4);
+    size_t len = raw ? BLOCK_HEADER + (packed ? packed : raw) : 0;
+
+    pthread_mutex_lock(&round->lock);
+    while (round->next != slot->index) pthread_cond_wait(&round->turn, &round->lock);
+    uint64_t off = round->offset;
+    round->offset += len;
+    ++round->next;
+    pthread_cond_broadcast(&round->turn);
+    pthread_mutex_unlock(&round->lock);
+
+    bool ok = raw && write_at((FILE *)round->w->fp, data, len, off);
+    if (!ok) {
+        pthread_mutex_lock(&round->lock);
+        round->failed = true;
+        pthread_mutex_unlock(&round->lock);
+    }
+    return NULL;
+}
+
+/* Encode and write every slot holding records, side by side */
+static void flush_round(StorageWriter *w) {
+    int used = w->filled + (w->filled < w->threads && w->slots[w->filled].n > 0);
+    if (used == 0) return;
+    if (!w->failed) {
+        WriteRound round = { w, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, w->bytes, false };
+        for (int t = 0; t < used; ++t) {
+            w->slots[t].round = &round;
+            w->slots[t].index = t;
+        }
+        for (int t = 1; t < used; ++t)
+            w->slots[t].started = pthread_create(&w->slots[t].tid, NULL, write_slot, &w->slots[t]) == 0;
+        write_slot(&w->slots[0]);
+        /* a slot without a thread runs here once the earlier ones have their offsets */
+        for (int t = 1; t < used; ++t) {
+            if (w->slots[t].started) pthread_join(w->slots[t].tid, NULL);
+            else write_slot(&w->slots[t]);
+        }
+        pthread_mutex_destroy(&round.lock);
+        pthread_cond_destroy(&round.turn);
+        w->bytes = round.offset;
+        if (round.failed) w->failed = true;
+    }
+    for (int t = 0; t < used; ++t) w->slots[t].n = 0;
+    w->filled = 0;
+}
+
+static void writer_free(StorageWriter *w) {
+    for (int t = 0; w->slots && t < w->threads; ++t) {
+        free(w->slots[t].block);
+        free(w->slots[t].raw);
+        free(w->slots[t].packed);
+    }
+    free(w->slots);
+    w->slots = NULL;
+}
+
+bool storage_writer_open(StorageWriter *w, const char *filename, uint64_t count) {
+    memset(w, 0, sizeof(*w));
+    snprintf(w->path, sizeof(w->path), "%s", filename);
+    snprintf(w->tmp_path, sizeof(w->tmp_path), "%s.tmp", w->path);
+    uint64_t blocks = (count + STORAGE_BLOCK_RECORDS - 1) / STORAGE_BLOCK_RECORDS;
+    w->threads = thread_count();
+    if ((uint64_t)w->threads > blocks) w->threads = blocks ? (int)blocks : 1;
+    w->slots = (struct StorageSlot *)calloc((size_t)w->threads, sizeof(struct StorageSlot));
+    FILE *f = w->slots ? fopen(w->tmp_path, "wb") : NULL;
+    if (!f) {
+        writer_free(w);
+        return false;
+    }
+    StorageHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, STORAGE_MAGIC, sizeof(h.magic));
+    h.version = STORAGE_VERSION;
+    h.endian_tag = STORAGE_ENDIAN_TAG;
+    h.record_count = count;
+    h.header_size = sizeof(StorageHeader);
+    h.block_records = STORAGE_BLOCK_RECORDS;
+    if (!write_at(f, &h, sizeof(h), 0)) {
+        fclose(f);
+        remove(w->tmp_path);
+        writer_free(w);
+        return false;
+    }
+    w->fp = f;
+    w->expected = count;
+    w->bytes = sizeof(h);
+    return true;
+}
+
+void storage_writer_put(StorageWriter *w, const Student *s) {
+    ++w->written;
+    if (w->failed) return;
+    struct StorageSlot *slot = &w->slots[w->filled];
+    if (!slot->block) {
+        /* buffers are allocated on first use, so small saves need one slot only */
+        slot->block = (Student *)malloc(sizeof(Student) * STORAGE_BLOCK_RECORDS);
+        slot->raw = (unsigned char *)malloc(BLOCK_HEADER + RAW_BOUND);
+        slot->packed = (unsigned char *)malloc(BLOCK_HEADER + RAW_BOUND);
+        if (!slot->block || !slot->raw || !slot->packed) {
+            w->failed = true;
+            return;
+        }
+    }
+    slot->block[slot->n++] = *s;
+    if (slot->n == STORAGE_BLOCK_RECORDS && ++w->filled == w->threads) flush_round(w);
+}
+
+bool storage_writer_close(StorageWriter *w) {
+    if (!w->fp) return false;
+    flush_round(w);
+    writer_free(w);
+    FILE *f = (FILE *)w->fp;
+    w->fp = NULL;
+    bool ok = !w->failed && w->written == w->expected && storage_sync(f);
+    if (fclose(f) != 0) ok = false;
+    if (ok) ok = storage_replace(w->tmp_path, w->path);
+    if (!ok) {
+        remove(w->tmp_path);
+        return false;
+    }
+    METRIC_ADD(MET_BYTES_WRITTEN, w->bytes);
+    return true;
+}
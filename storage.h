@@ -0,0 +1,119 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include "student.h"
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Versioned on-disk snapshot format: a StorageHeader, then the records. The header
+   records the writer's byte order so files from the other endianness can be read.
+
+   Version 3 (written): blocks of STORAGE_BLOCK_RECORDS records (the last one may be
+   shorter), each sorted by roll; database.c writes all records in roll order. A block is two little-endian u32s, the stored
+   payload size and its size before compression (0: stored as is), then the payload,
+   compressed with lz.h when that saves at least an eighth. The payload of n records:
+     rolls   the first roll as a zigzag varint, then varint gaps to the next roll
+     values  per subject and then attendance: n little-endian u16 in hundredths;
+             0xffff marks a value that is not a multiple of 0.01, followed by a varint
+             count and (varint row, 8-byte little-endian double) for each of them
+     names   n varint lengths, then the names back to back (the block's string heap)
+   The benchmark roster takes about 32 bytes a student, 19 compressed, instead of 152.
+
+   Version 2 (read only): fixed-layout StorageRecords with no pointer and no padding.
+   Files written by the old raw-struct layout are still readable (see storage_map).
+   Either is rewritten as version 3 on the next save. */
+
+#define STORAGE_MAGIC "SRMSDB\0\0"
+#define STORAGE_VERSION 3
+#define STORAGE_VERSION_FIXED 2
+#define STORAGE_ENDIAN_TAG 0x01020304U
+#define STORAGE_BLOCK_RECORDS 4096
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t endian_tag;   /* STORAGE_ENDIAN_TAG in the writer's byte order */
+    uint64_t record_count;
+    uint32_t record_size;   /* sizeof(StorageRecord) in version 2, 0 in version 3 */
+    uint32_t header_size;   /* sizeof(StorageHeader) */
+    uint32_t block_records; /* version 3: records per block */
+    uint8_t reserved[28];
+} StorageHeader;
+
+typedef struct {
+    int32_t roll;
+    char name[NAME_LEN];
+    double marks[NUM_SUBJECTS];
+    double attendance;
+} StorageRecord;
+
+/* Read-only view of a snapshot file, memory-mapped where the platform allows */
+typedef struct {
+    const unsigned char *records; /* first record (or block) inside the mapping */
+    uint64_t count;
+    size_t record_size;
+    bool byteswap;  /* file written on a machine of the other endianness */
+    bool legacy;    /* old raw Student layout */
+    bool outdated;  /* not the current version (raw layout or version 2); rewrite it */
+    void *map;      /* whole-file mapping (or heap buffer) */
+    size_t map_len;
+    /* version 3: block offsets */
+    size_t *blocks;
+    uint64_t block_count;
+    uint32_t block_records;
+} StorageView;
+
+/* Map filename. A missing file yields an empty view and returns true.
+   Returns false if the file exists but is unreadable or malformed. */
+bool storage_map(const char *filename, StorageView *v);
+
+/* Visit every record of the mapping in parallel-decoded chunks: worker threads
+   decode (and check) a round of blocks while fn consumes the previous round, in
+   file order, or reverse file order when backwards (records within a chunk are
+   still in file order). Stops early when fn returns false. Returns false if a
+   block is corrupt, memory runs out, or fn stopped the scan. */
+bool storage_scan(const StorageView *v, bool backwards,
+                  bool (*fn)(const Student *recs, size_t n, void *ctx), void *ctx);
+
+void storage_unmap(StorageView *v);
+
+/* Streaming snapshot writer; count must match the number of storage_writer_put calls.
+   Records go to "<filename>.tmp", which replaces filename only once it is complete
+   and on disk, so a crash mid-save leaves the previous snapshot intact. Up to one
+   block per thread is buffered; a full round is encoded on worker threads, each
+   block written with pwrite at an offset reserved in block order. */
+typedef struct {
+    void *fp;
+    uint64_t expected;
+    uint64_t written;
+    uint64_t bytes; /* file size so far */
+    bool failed;
+    char path[512];
+    char tmp_path[520];
+    struct StorageSlot *slots; /* blocks being filled, encoded together */
+    int threads;
+    int filled;                /* slots full so far in this round */
+} StorageWriter;
+
+bool storage_writer_open(StorageWriter *w, const char *filename, uint64_t count);
+void storage_writer_put(StorageWriter *w, const Student *s);
+/* Flushes, fsyncs and renames the temp file over the target. Returns false (and
+   removes the temp file) if any write failed or the count did not match. */
+bool storage_writer_close(StorageWriter *w);
+
+/* Compress snapshot blocks (default on). Off trades file size for save time. */
+void storage_set_compression(bool on);
+
+/* Worker threads for storage_scan and the writer; 0 (the default) uses one per
+   online CPU, up to 16. 1 keeps everything on the calling thread. */
+void storage_set_threads(int n);
+
+/* fflush + fsync: the data reaches the disk, not just the OS cache. */
+bool storage_sync(FILE *f);
+
+/* Atomically replace path with tmp_path and make the rename itself durable. */
+bool storage_replace(const char *tmp_path, const char *path);
+
+#endif /* STORAGE_H */
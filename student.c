@@ -2,10 +2,28 @@
 #include <stdlib.h>
 #include <string.h>
 #include "student.h"
+#include "pool.h"
+
+/* Students per slab: ~640 KiB blocks keep large rosters contiguous */
+#define STUDENTS_PER_SLAB 4096
+
+static Pool student_pool = POOL_INIT(Student, STUDENTS_PER_SLAB);
+
+Student *student_alloc(void) {
+    return (Student *)pool_alloc(&student_pool);
+}
+
+void free_student(Student *s) {
+    pool_free(&student_pool, s);
+}
+
+void student_release_all(void) {
+    pool_release(&student_pool);
+}
 
 /* Create a new student struct and copy data into it */
 Student *create_student(const char *name, int roll, double marks[], double attendance) {
-    Student *s = (Student *) malloc(sizeof(Student));
+    Student *s = student_alloc();
     if (!s) return NULL;
     strncpy(s->name, name, NAME_LEN-1);
     s->name[NAME_LEN-1] = '\0';
@@ -49,9 +67,10 @@ int student_count_below(const Student *s, double threshold) {
 
 /* Validate marks and attendance are within 0-100 inclusive */
 bool validate_marks_and_attendance(const double marks[], double attendance) {
-    if (attendance < 0.0 || attendance > 100.0) return false;
+    /* written as in-range tests so NaN is rejected too */
+    if (!(attendance >= 0.0 && attendance <= 100.0)) return false;
     for (int i = 0; i < NUM_SUBJECTS; ++i) {
-        if (marks[i] < 0.0 || marks[i] > 100.0) return false;
+        if (!(marks[i] >= 0.0 && marks[i] <= 100.0)) return false;
     }
     return true;
 }
@@ -15,10 +15,19 @@ typedef struct Student {
     struct Student *next; /* for linked list in database */
 } Student;
 
-/* Create and return a new student (dynamically allocated).
-   Caller responsible for freeing via database deletion functions. */
+/* Create and return a new student (allocated from the student pool).
+   Caller responsible for freeing via database deletion functions, or free_student if never added. */
 Student *create_student(const char *name, int roll, double marks[], double attendance);
 
+/* Uninitialized Student slot from the pool (NULL on allocation failure). */
+Student *student_alloc(void);
+
+/* Return a student to the pool (NULL is ignored). */
+void free_student(Student *s);
+
+/* Drop every pool slab at once; every Student handed out becomes invalid. */
+void student_release_all(void);
+
 /* Print a single student record in a friendly format */
 void print_student(const Student *s);
 